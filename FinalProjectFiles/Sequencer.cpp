@@ -12,8 +12,9 @@
 * creating circular buffers for ADS-B and ACARS data. It launches three threads -
 * (readerThread) to continuously read radio signals (SDR) into these buffers and 
 * two processing services are configured: processAcarsand 
-* processAdsb, which handle message decoding. The function then enters an infinite 
-* loop to visualize aircraft positions on a map (plotAircrafsOnMap).
+* processAdsb, which handle message decoding. The stages and the queues between
+* them are laid out as a pipeline (see pipeline.h). The function then enters an
+* infinite loop to visualize aircraft positions on a map (plotAircrafsOnMap).
 *******************************************************************************/
 
 #include <cstdint>
@@ -24,150 +25,642 @@
 #include <linux/gpio.h>
 #include <sys/ioctl.h>
 #include <sys/mman.h>
+#include <unistd.h>
 #include <thread>
 #include <string_view>
+#include <memory>
 #include "Sequencer.hpp"
 #include "adsb.h"
+#include "samplesource.h"
+#include "synthetic.h"
+#include "recording.h"
+#include "bandscheduler.h"
+#include "bufferpool.h"
+#include "pipeline.h"
+#include "modescrc.h"
+#include "modesdsp.h"
 
-//#define BLOCK_SIZE (4 * 1024)
-#define SET_BUFFER_LENGTH RTLOUTBUFSZ * 160 * 2
 
 static Sequencer sequencer{};
-static RtlSdr sdr{};
-Adsb adsbObject{};
-Acars acarsObject{};
-Plotter plotter{};
+static std::unique_ptr<SampleSource> source;
+static std::unique_ptr<Recorder> recorder;
+static std::unique_ptr<RecordingReplay> replay;
+static SyntheticSource* generator = nullptr;
+static std::unique_ptr<BandScheduler> scheduler;
+static std::unique_ptr<BufferPool> pool;
+static Pipeline pipeline{sequencer};
 
-//uint8_t bufferAdsb[SET_BUFFER_LENGTH];
-uint8_t bufferAcars[SET_BUFFER_LENGTH];
+// Node state: each object is only touched by the node that owns it
+static Adsb adsbObject{};   // "ADS-B demod", then "Track" through track()
+static Acars acarsObject{}; // "ACARS decode"
+static Plotter plotter{};   // "Render", on the main thread
 
-CircularBuffer* adsbCb = nullptr;
-CircularBuffer* acarsCb = nullptr;
+// Edges
+static CircularBuffer* adsbCb = nullptr;   // capture -> ADS-B demod, IQ blocks
+static CircularBuffer* acarsCb = nullptr;  // capture -> ACARS decode, IQ blocks
+static SpscQueue<ModesFrame> frames{4096};         // ADS-B demod -> Track
+static SpscQueue<std::vector<Aircraft>> tracks{4}; // Track -> Render, table snapshots
 
+//Draws the latest aircraft table published by the track node, or the
+//previous one again when nothing new arrived
 void plotAircrafsOnMap()
 {
-    plotter.plotAircrafts(adsbObject.getAircrafts());
+    static std::vector<Aircraft> aircrafts;
+    std::vector<Aircraft> latest;
+    while (tracks.pop(latest))
+    {
+        aircrafts.swap(latest);
+    }
+    plotter.plotAircrafts(aircrafts);
 }
 
-void processAdsb()
+// Per-decoder state for draining its ring within a time budget (-D).
+// Without a budget a release decodes one block, as before.
+struct Drain
 {
-    RTLBuffer* b2 = adsbCb->getPtrToTail();
-    if (b2 == nullptr || b2->n_read == 0)
+    uint64_t budgetNs = 0;
+    uint64_t blockNs = 0;      // running average time to decode one block
+    uint64_t exhausted = 0;    // releases that left blocks queued for lack of budget
+    LatencyHistogram blocks;   // blocks decoded per release
+};
+
+static Drain adsbDrain;
+static Drain acarsDrain;
+
+// Decodes queued blocks until the ring is empty or the next block, at the
+// average cost so far, would not finish inside the budget. The first block
+// always goes, so a release never makes no progress.
+template<typename Decode>
+static void drainRing(CircularBuffer* ring, Drain& d, Decode&& decode)
+{
+    const uint64_t start = monotonicNs();
+    uint64_t n = 0;
+    RTLBuffer* b2;
+    while ((b2 = ring->peek()) != nullptr)
     {
-        return;
+        if (n > 0 && d.budgetNs == 0)
+        {
+            break;
+        }
+        if (n > 0 && monotonicNs() - start + d.blockNs > d.budgetNs)
+        {
+            d.exhausted++;
+            break;
+        }
+
+        const uint64_t blockStart = monotonicNs();
+        if (b2->n_read > 0)
+        {
+            if (recorder)
+            {
+                recorder->write(*b2);
+            }
+            decode(b2);
+        }
+        ring->consume();
+
+        const uint64_t t = monotonicNs() - blockStart;
+        d.blockNs = d.blockNs == 0 ? t : (d.blockNs * 7 + t) / 8;
+        n++;
     }
-   //printf("processAdsb: Read %d bytes from SDR\n", b2->n_read);
-    adsbObject.processData(b2->buffer, b2->n_read);
-    adsbCb->pop();
+    d.blocks.add(n);
+}
+
+static void printDrain(const char* name, Drain& d)
+{
+    cout << "\n***Printing drain stats for " << name << "***" << endl;
+    cout << "Budget: " << d.budgetNs / 1000000.0 << "ms per release, average block "
+         << d.blockNs / 1000000.0 << "ms" << endl;
+    cout << "Blocks per release: p50 " << d.blocks.percentile(0.5) << " p99 " << d.blocks.percentile(0.99)
+         << " max " << d.blocks.max() << " avg " << d.blocks.mean() << endl;
+    cout << "Releases out of budget with blocks queued: " << d.exhausted << endl;
+}
+
+void processAdsb()
+{
+    drainRing(adsbCb, adsbDrain, [](RTLBuffer* b2) {
+       //printf("processAdsb: Read %d bytes from SDR\n", b2->n_read);
+        adsbObject.processData(b2->buffer, b2->n_read, b2->sampleIndex);
+    });
 }
 
 void processAcars()
 {
-    RTLBuffer* b2 = acarsCb->getPtrToTail();
-    if (b2 == nullptr || b2->n_read == 0)
+    drainRing(acarsCb, acarsDrain, [](RTLBuffer* b2) {
+        acarsObject.processData(b2->buffer, b2->n_read);
+    });
+}
+
+//Folds the frames the demodulator queued into the aircraft table and hands
+//the render loop a copy of it when anything changed
+void trackAircrafts()
+{
+    ModesFrame frame;
+    uint64_t n = 0;
+    while (frames.pop(frame))
     {
-        return;
+        adsbObject.track(frame);
+        n++;
     }
+    if (n > 0)
+    {
+        tracks.push(adsbObject.snapshot());
+    }
+}
 
-    acarsObject.processData(b2->buffer, b2->n_read);
-    acarsCb->pop();
+//Logs the edge counters once a second, so overruns show up while running
+void monitorRings()
+{
+    pipeline.logEdges();
 }
 
-//Continuously reads data from an SDR (Software-Defined Radio) device and stores 
-//it in two different buffers: one for ADSB and one for ACARS
+//Reads from the sample source into the ADS-B and ACARS buffers, one whole
+//dwell per release, read back to back, on the band the band scheduler picks
 void readBuffer()
 {
-    // For ADSB data
-    RTLBuffer *bAdsb = adsbCb->getPtrToHead();
-    if (bAdsb == nullptr)
+    scheduler->readDwell();
+}
+
+static void cleanup(int sigid)
+{
+    sequencer.stopServices();
+    if (source)
     {
-        return;
+        source->stopStreaming();
     }
+    if (replay)
+    {
+        replay->stop();
+    }
+    sequencer.printStatistics();
+    sequencer.analyze(true);
+    if (source)
+    {
+        source->printStats();
+    }
+    if (scheduler)
+    {
+        scheduler->printStats();
+    }
+    if (recorder)
+    {
+        recorder->printStats();
+    }
+    pipeline.printEdges();
+    printDrain("ADS-B demod", adsbDrain);
+    printDrain("ACARS decode", acarsDrain);
+    pool->printStats();
+    if (replay)
+    {
+        replay->printStats();
+    }
+    adsbObject.printStats();
+    acarsObject.printStats();
+    if (generator != nullptr && generator->framesDelivered() > 0)
+    {
+        cout << "\nDF17 decode rate: "
+             << 100.0 * adsbObject.df17Frames() / generator->framesDelivered() << "%\n";
+    }
+    if (generator != nullptr && generator->repliesDelivered() > 0)
+    {
+        cout << "Address/Parity reply acceptance rate: "
+             << 100.0 * adsbObject.apFrames() / generator->repliesDelivered() << "%\n";
+    }
+    if (generator != nullptr && generator->burstsDelivered() > 0)
+    {
+        cout << "ACARS decode rate: "
+             << 100.0 * acarsMessages() / generator->burstsDelivered() << "%\n";
+    }
+    adsbObject.printAircrafts();
+    closelog();
+    plotter.close();
+    delete adsbCb;
+    delete acarsCb;
+    cout << "\nExiting, bye!\n";
+    exit(0);
+}
 
-    adsbCb->push();
-    
-    auto logTime = [](std::string_view log){auto now = std::chrono::system_clock::now();
-        auto duration = now.time_since_epoch();
-        auto microseconds = std::chrono::duration_cast<std::chrono::microseconds>(duration);
-        syslog(LOG_INFO, "%s: %ld",log.data(), microseconds.count());
-    };
-    
-    logTime("Before readSdr ADSB:");
-    int readLen = sdr.readSdr(ADSB_FREQUENCY, bAdsb->buffer, BLOCK_SIZE);
-    logTime("After readSdr ADSB:");
+// Drain budgets per release (-D), in ms; 0 decodes one block per release
+static bool parseDrain(char* spec)
+{
+    enum { ADSB, ACARS };
+    char kAdsb[] = "adsb", kAcars[] = "acars";
+    char* const keys[] = {kAdsb, kAcars, nullptr};
 
-    if (readLen < 0)
+    char* value;
+    while (*spec != '\0')
     {
-        perror("Unable to read from SDR");
-        return;
+        int key = getsubopt(&spec, keys, &value);
+        if (key < 0 || value == nullptr)
+        {
+            return false;
+        }
+        (key == ADSB ? adsbDrain : acarsDrain).budgetNs = strtoull(value, nullptr, 0) * 1000000ull;
     }
+    return true;
+}
 
-    // printf("readbuffer: read %d\n", readLen);
-
-    bAdsb->n_read = readLen;
+// Bounds for the adaptive decoder periods (-A), in ms
+struct AdaptiveConfig
+{
+    bool enabled = false;
+    uint32_t minPeriod = 20;
+    uint32_t maxPeriod = 500;
 
-    // For ACARS data
-    RTLBuffer *bAcars = acarsCb->getPtrToHead();
-    if (bAcars == nullptr)
+    bool parse(char* spec)
     {
-        return;
-    }
+        enum { MIN, MAX };
+        char kMin[] = "min", kMax[] = "max";
+        char* const keys[] = {kMin, kMax, nullptr};
 
-    acarsCb->push();
+        enabled = true;
+        char* value;
+        while (*spec != '\0')
+        {
+            int key = getsubopt(&spec, keys, &value);
+            if (key < 0 || value == nullptr)
+            {
+                return false;
+            }
+            (key == MIN ? minPeriod : maxPeriod) = strtoul(value, nullptr, 0);
+        }
+        return minPeriod > 0 && minPeriod <= maxPeriod;
+    }
+};
 
-    readLen = sdr.readSdr(acarsObject.getFrequency(), bAcars->buffer, BLOCK_SIZE);
+// Declared worst-case execution times for the admission check (-W), in ms
+struct WcetConfig
+{
+    uint32_t reader = 0;  // 0: derived from the block size, see main()
+    uint32_t adsb = 0;    // 0: unknown
+    uint32_t acars = 0;
+    bool strict = false;  // refuse to start a set that can miss deadlines
 
-    if (readLen < 0)
+    bool parse(char* spec)
     {
-        perror("Unable to read from SDR");
-        return;
+        enum { READER, ADSB, ACARS, STRICT };
+        char kReader[] = "reader", kAdsb[] = "adsb", kAcars[] = "acars", kStrict[] = "strict";
+        char* const keys[] = {kReader, kAdsb, kAcars, kStrict, nullptr};
+
+        char* value;
+        while (*spec != '\0')
+        {
+            int key = getsubopt(&spec, keys, &value);
+            if (key == STRICT)
+            {
+                strict = true;
+                continue;
+            }
+            if (key < 0 || value == nullptr)
+            {
+                return false;
+            }
+            uint32_t ms = strtoul(value, nullptr, 0);
+            (key == READER ? reader : key == ADSB ? adsb : acars) = ms;
+        }
+        return true;
     }
+};
 
-    // printf("readbuffer: read %d\n", readLen);
+// Calibration run (-L): a do-nothing 1 ms service on every CPU, released
+// by the same dispatcher as the decoders, so the release latency it reports
+// is what the real services would see on this host. Periods are whole ms,
+// so a release that is a millisecond late has slipped a full tick.
+static int calibrate(int seconds)
+{
+    const unsigned cpus = std::max(1u, std::thread::hardware_concurrency());
+    Sequencer probe{};
+    vector<string> names;
+    for (unsigned cpu = 0; cpu < cpus; cpu++)
+    {
+        names.push_back("probe cpu" + to_string(cpu));
+    }
+    for (unsigned cpu = 0; cpu < cpus; cpu++)
+    {
+        probe.addService([] {}, cpu, 98, 1, names[cpu].c_str());
+    }
 
-    bAcars->n_read = readLen;
-}
+    cout << "Measuring release latency on " << cpus << " CPUs for " << seconds << "s...\n";
+    probe.startServices();
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    probe.stopServices();
+    probe.printStatistics();
 
-#if 1
-static void timerCallback(int sigid)
-{
-    trace(__func__);
-#if 0
-    auto now = std::chrono::system_clock::now();
-            auto now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-                              now.time_since_epoch())
-                              .count();
-    syslog(LOG_INFO, "Starting service at time %ld ms",now_ms);
-#endif
-    sequencer.startServices();
+    const uint64_t worst = probe.maxReleaseLatency();
+    cout << "\nWorst release latency " << worst / 1000.0 << "us: "
+         << (worst < 1000000 ? "within" : "EXCEEDS") << " the 1 ms service tick\n";
+    return worst < 1000000 ? 0 : 2;
 }
-#endif
 
-static void cleanup(int sigid)
+static void usage(const char* prog)
 {
-    sequencer.stopServices();
-    sequencer.printStatistics();
-    adsbObject.printAircrafts();
-    closelog();
-    plotter.close();
-    delete adsbCb;
-    delete acarsCb;
-    cout << "\nExiting, bye!\n";
-    exit(0);
+    cout << "Usage: " << prog << " [-c] [-f file.iq [-l]] [-g aircraft [-G opts]] [-w file.rec] [-r file.rec] [-m opts] [-D opts] [-A opts] [-W opts] [-P n] [-T n] [-E n] [-L secs] [-K]\n"
+         << "  -c  continuous capture: stream ADS-B with rtlsdr_read_async\n"
+         << "      instead of retuning between ADS-B and ACARS\n"
+         << "  -f  replay a raw u8 IQ capture taken at 1090 MHz instead of the dongle\n"
+         << "  -l  loop the IQ file\n"
+         << "  -g  generate synthetic ADS-B and ACARS traffic from this many aircraft\n"
+         << "  -G  generator options, comma separated key=value:\n"
+         << "        rate=2 ident=0.2  DF17 positions/identifications per aircraft per s\n"
+         << "        surv=0            DF4/DF5 replies (altitude, squawk) per aircraft per s\n"
+         << "        acars=6           ACARS bursts per channel per minute\n"
+         << "        noise=3           noise sigma in u8 counts\n"
+         << "        amin=20 amax=100  signal amplitude range in u8 counts\n"
+         << "        overlap=1         0 makes transmissions wait for a clear channel\n"
+         << "        truth=file.csv    write every transmission to a CSV\n"
+         << "        seed=1090\n"
+         << "  -w  record every block the decoders get, with its metadata\n"
+         << "  -r  replay a recording through the decoders as fast as they go\n"
+         << "  -m  capture buffer options, comma separated key=value:\n"
+         << "        adsb=100 acars=100  blocks in the ADS-B / ACARS rings\n"
+         << "        size=327680         ADS-B block size in bytes (multiple of 512)\n"
+         << "        huge=0              back the rings with hugepages\n"
+         << "        lock=0              mlock the rings\n"
+         << "        policy=drop         when a ring is full: drop the new block,\n"
+         << "                            overwrite the oldest unread one (drops the\n"
+         << "                            new one while the oldest is decoding), or block\n"
+         << "        timeout=50          ms to wait with policy=block\n"
+         << "  -D  let each decoder release work through its backlog for up to\n"
+         << "      a time budget instead of one block: adsb=ms,acars=ms\n"
+         << "  -A  adapt the decoder periods to their ring backlog, between\n"
+         << "      min=20 and max=500 ms (-A \"\" for the defaults)\n"
+         << "  -W  declared worst-case execution times for the startup\n"
+         << "      schedulability check, comma separated:\n"
+         << "        reader=ms adsb=ms acars=ms\n"
+         << "        strict              refuse to start if a deadline can be missed\n"
+         << "  -P  demodulate each ADS-B block in n segments at once, on the\n"
+         << "      ADS-B demod CPU and the n - 1 after it\n"
+         << "  -T  fuse magnitude and detection in tiles of n samples (4096 fits\n"
+         << "      L1) instead of converting whole blocks; not with -P\n"
+         << "  -E  repair DF11/DF17 frames with up to n bad bits: 0 off, 1 (default),\n"
+         << "      2 also two bit errors in DF17, at the cost of some false decodes\n"
+         << "  -L  measure service release latency on every CPU for secs seconds\n"
+         << "      and exit; run as root so SCHED_FIFO applies\n"
+         << "  -K  check the demodulator's SIMD and CRC kernels against the reference\n"
+         << "      versions, time them and exit\n";
 }
 
-int main()
+int main(int argc, char* argv[])
 {
+    bool continuous = false;
+    const char* iqFile = nullptr;
+    bool loop = false;
+    int synthetic = 0;
+    SyntheticConfig syntheticConfig;
+    PoolConfig poolConfig;
+    WcetConfig wcet;
+    AdaptiveConfig adaptive;
+    const char* recordFile = nullptr;
+    const char* replayFile = nullptr;
+    int demodSegments = 1;
+    int tileSamples = 0;
+    int fixBits = 1;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "cf:lg:G:w:r:m:D:A:W:P:T:E:L:Kh")) != -1)
+    {
+        switch (opt)
+        {
+        case 'c':
+            continuous = true;
+            break;
+        case 'f':
+            iqFile = optarg;
+            break;
+        case 'l':
+            loop = true;
+            break;
+        case 'g':
+            synthetic = atoi(optarg);
+            break;
+        case 'G':
+            if (syntheticConfig.parse(optarg) == false)
+            {
+                cerr << "Bad generator option in " << optarg << endl;
+                return 1;
+            }
+            break;
+        case 'w':
+            recordFile = optarg;
+            break;
+        case 'r':
+            replayFile = optarg;
+            break;
+        case 'm':
+            if (poolConfig.parse(optarg) == false)
+            {
+                cerr << "Bad buffer option in " << optarg << endl;
+                return 1;
+            }
+            break;
+        case 'D':
+            if (parseDrain(optarg) == false)
+            {
+                cerr << "Bad drain option in " << optarg << endl;
+                return 1;
+            }
+            break;
+        case 'A':
+            if (adaptive.parse(optarg) == false)
+            {
+                cerr << "Bad adaptive option in " << optarg << endl;
+                return 1;
+            }
+            break;
+        case 'W':
+            if (wcet.parse(optarg) == false)
+            {
+                cerr << "Bad WCET option in " << optarg << endl;
+                return 1;
+            }
+            break;
+        case 'P':
+            demodSegments = atoi(optarg);
+            if (demodSegments < 1)
+            {
+                cerr << "Bad segment count " << optarg << endl;
+                return 1;
+            }
+            break;
+        case 'T':
+            tileSamples = atoi(optarg);
+            if (tileSamples < 256)
+            {
+                cerr << "Tiles need at least 256 samples\n";
+                return 1;
+            }
+            break;
+        case 'E':
+            fixBits = atoi(optarg);
+            if (fixBits < 0 || fixBits > 2)
+            {
+                cerr << "Error correction is 0, 1 or 2 bits\n";
+                return 1;
+            }
+            break;
+        case 'L':
+            return calibrate(std::max(1, atoi(optarg)));
+        case 'K':
+        {
+            bool ok = benchmarkKernels();
+            ok = benchmarkCrc() && ok;
+            return ok ? 0 : 1;
+        }
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+
     openlog("Sequencer", LOG_PID | LOG_CONS, LOG_USER);
 
-    adsbCb = new CircularBuffer[CIRCULAR_BUFFER_SIZE];
-    acarsCb = new CircularBuffer[CIRCULAR_BUFFER_SIZE];
+    try
+    {
+        if (recordFile != nullptr)
+        {
+            recorder = make_unique<Recorder>(recordFile, std::max<uint32_t>(poolConfig.adsbBlockSize, BLOCK_SIZE));
+        }
 
-    sequencer.addService(readBuffer, 2, 99, 300, "Reader thread");
-    sequencer.addService(processAdsb, 1, 99, 140, "processAdsb");
-    sequencer.addService(processAcars, 1, 98, 150, "processAcars");
-    
-    sequencer.initTimer(timerCallback);
+        if (replayFile != nullptr)
+        {
+            replay = make_unique<RecordingReplay>(replayFile);
+        }
+        else if (iqFile != nullptr)
+        {
+            source = make_unique<IqFileSource>(iqFile, ADSB_FREQUENCY, loop);
+        }
+        else if (synthetic > 0)
+        {
+            syntheticConfig.aircraft = synthetic;
+            auto s = make_unique<SyntheticSource>(syntheticConfig);
+            generator = s.get();
+            source = std::move(s);
+        }
+        else
+        {
+            source = make_unique<RtlSdr>();
+        }
+    }
+    catch (const std::exception& e)
+    {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    // All capture blocks come out of one allocation made here, up front
+    try
+    {
+        pool = make_unique<BufferPool>(poolConfig.bytes(), poolConfig.hugePages, poolConfig.lock);
+        size_t adsbBytes = (size_t)poolConfig.adsbBlocks * poolConfig.adsbBlockSize;
+        size_t acarsBytes = (size_t)poolConfig.acarsBlocks * BLOCK_SIZE;
+        adsbCb = new CircularBuffer(pool->take(adsbBytes), poolConfig.adsbBlocks, poolConfig.adsbBlockSize);
+        acarsCb = new CircularBuffer(pool->take(acarsBytes), poolConfig.acarsBlocks, BLOCK_SIZE);
+    }
+    catch (const std::exception& e)
+    {
+        cerr << e.what() << endl;
+        return 1;
+    }
+    adsbCb->setPolicy(poolConfig.policy, poolConfig.timeoutMs);
+    acarsCb->setPolicy(poolConfig.policy, poolConfig.timeoutMs);
+    cout << "Capture buffers: " << pool->size() / (1024 * 1024) << "MB for "
+         << poolConfig.adsbBlocks << " ADS-B and " << poolConfig.acarsBlocks << " ACARS blocks\n";
+
+    // Consumer period: back to back when replaying, so decoders run at CPU speed
+    uint32_t adsbPeriod = 140;
+    uint32_t acarsPeriod = 150;
+
+    if (replay)
+    {
+        replay->start(ADSB_FREQUENCY, adsbCb, acarsCb);
+        adsbPeriod = acarsPeriod = 1;
+        pipeline.addExternalNode("Capture", "replay thread");
+    }
+    else if (continuous)
+    {
+        // The source fills adsbCb from its own thread; no reader service needed
+        if (source->startStreaming(ADSB_FREQUENCY, adsbCb) == false)
+        {
+            cerr << "Unable to start continuous capture\n";
+            return 1;
+        }
+        pipeline.addExternalNode("Capture", "USB streaming thread");
+    }
+    else
+    {
+        // An ACARS message only decodes if the whole burst (up to ~0.4 s)
+        // falls in one dwell, and it is unique where a DF17 squitter is
+        // repeated twice a second, hence the minimum dwell of 5 blocks
+        // (0.41 s, read back to back in one release) and the weight
+        scheduler = make_unique<BandScheduler>(source.get());
+        scheduler->addBand("ADS-B", ADSB_FREQUENCY, adsbCb,
+                           [] { return adsbObject.df17Frames(); }, 1.0, 1);
+        scheduler->addBand("ACARS", acarsObject.getFrequency(), acarsCb,
+                           [] { return (uint64_t)acarsMessages(); }, 100.0, 5);
+        // a release reads a whole dwell, so the reader's period is the
+        // longest dwell plus its retune settle at the nominal sample rate,
+        // with a twentieth on top for USB latency; unless declared, that
+        // dwell is also its WCET
+        uint64_t samples = std::max<uint64_t>(poolConfig.adsbBlockSize, BLOCK_SIZE) / 2 * scheduler->maxDwell() +
+                           BAND_SETTLE_SAMPLES;
+        uint64_t dwellUs = samples * 1000000ull / MODES_DEFAULT_RATE;
+        uint32_t readerPeriod = (dwellUs * 21 / 20 + 999) / 1000;
+        uint64_t readerUs = wcet.reader > 0 ? wcet.reader * 1000ull : dwellUs;
+        pipeline.addNode("Capture", readBuffer, 2, 99, readerPeriod, readerUs);
+    }
+    // a draining decoder stops before a block that would not fit its
+    // budget, so the budget stands in for an undeclared WCET
+    if (wcet.adsb == 0)
+    {
+        wcet.adsb = adsbDrain.budgetNs / 1000000;
+    }
+    if (wcet.acars == 0)
+    {
+        wcet.acars = acarsDrain.budgetNs / 1000000;
+    }
+    // demodulated frames go to the track node instead of being tracked on
+    // the decoder's CPU; a full edge drops frames, counted in its stats
+    adsbObject.setFrameSink([](const ModesFrame& frame) { frames.push(frame); });
+
+    // segment workers sit on the CPUs after the demod node's, one below its
+    // priority so the reader on CPU 2 still preempts them
+    adsbObject.setDemodSegments(demodSegments, [](size_t worker) {
+        const unsigned cpus = std::max(1u, std::thread::hardware_concurrency());
+        string name = "ADS-B seg " + to_string(worker);
+        configureThread((1 + worker) % cpus, 97, name.c_str());
+    });
+    adsbObject.setTileSamples(tileSamples);
+    adsbObject.setErrorCorrection(fixBits);
+
+    pipeline.addNode("ADS-B demod", processAdsb, 1, 99, adsbPeriod, wcet.adsb * 1000);
+    pipeline.addNode("ACARS decode", processAcars, 1, 98, acarsPeriod, wcet.acars * 1000);
+    pipeline.addNode("Track", trackAircrafts, 0, 50, 100);
+    pipeline.addExternalNode("Render", "main thread");
+    pipeline.addNode("Monitor", monitorRings, 0, 1, 1000);
+    pipeline.addEdge("ADS-B IQ", "Capture", "ADS-B demod", adsbCb);
+    pipeline.addEdge("ACARS IQ", "Capture", "ACARS decode", acarsCb);
+    pipeline.addEdge("Mode S frames", "ADS-B demod", "Track", &frames);
+    pipeline.addEdge("Tracks", "Track", "Render", &tracks);
+    pipeline.printGraph();
+
+    // a replay already runs the decoders back to back
+    if (adaptive.enabled && !replay)
+    {
+        sequencer.adaptPeriod("ADS-B demod", [] { return adsbCb->size(); },
+                              adaptive.minPeriod, adaptive.maxPeriod);
+        sequencer.adaptPeriod("ACARS decode", [] { return acarsCb->size(); },
+                              adaptive.minPeriod, adaptive.maxPeriod);
+    }
+
+    if (sequencer.analyze(false) == false)
+    {
+        cerr << "The service set can miss deadlines with the declared WCETs\n";
+        if (wcet.strict)
+        {
+            sequencer.stopServices();  // the service threads are already waiting
+            return 1;
+        }
+    }
     sequencer.startServices();
 
     std::signal(SIGINT, cleanup);
@@ -19,13 +19,15 @@
 #include <semaphore>
 #include <atomic>
 #include <time.h>
-#include <signal.h>
+#include <errno.h>
 #include <stdlib.h>
 #include <iostream>
 #include <syslog.h>
 #include <ctime>
 #include <chrono>
 #include <algorithm> // For std::min and std::max
+#include <cstdio>
+#include "histogram.h"
 
 using namespace std;
 
@@ -38,15 +40,73 @@ void trace(const char* func)
 }
 
 
+// Pins the calling thread to one CPU, makes it SCHED_FIFO at 'priority'
+// and names it, reporting (but surviving) failures; shared by the service
+// threads and the dispatcher.
+void configureThread(uint8_t affinity, uint8_t priority, const char* name)
+{
+    pthread_t native_handle = pthread_self();
+
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    CPU_SET(affinity, &cpuset);
+    if (pthread_setaffinity_np(native_handle, sizeof(cpu_set_t), &cpuset) != 0) {
+        std::cerr << "Failed to set CPU affinity\n";
+    }
+    else
+    {
+        //std::cout << "Affinity set success!\n";
+    }
+
+    struct sched_param param;
+    param.sched_priority = priority;
+
+    if (pthread_setschedparam(native_handle, SCHED_FIFO, &param) != 0) {
+        std::cerr << "Failed to set thread priority\n";
+    }
+    else
+    {
+        //std::cout << "Thread priority set success!\n";
+    }
+
+    pthread_setname_np(native_handle, name);
+}
+
+// CLOCK_MONOTONIC as nanoseconds, and back, for the dispatcher's deadlines
+static inline uint64_t monotonicNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static inline struct timespec toTimespec(uint64_t ns)
+{
+    struct timespec ts;
+    ts.tv_sec = ns / 1000000000ull;
+    ts.tv_nsec = ns % 1000000000ull;
+    return ts;
+}
+
+// One line of a histogram's percentiles, in microseconds
+void printLatency(const char* name, LatencyHistogram& h)
+{
+    printf("%s (us): min %.1f p50 %.1f p99 %.1f p99.9 %.1f max %.1f avg %.1f\n", name,
+           h.min() / 1000.0, h.percentile(0.5) / 1000.0, h.percentile(0.99) / 1000.0,
+           h.percentile(0.999) / 1000.0, h.max() / 1000.0, h.mean() / 1000.0);
+}
+
 // The service class contains the service function and service parameters
 // (priority, affinity, etc). It spawns a thread to run the service, configures
 // the thread as required, and executes the service whenever it gets released.
 class Service
 {
 public:
+    // 'wcetUs' is the declared worst-case execution time, 0 if unknown
     template<typename T>
-    Service(T&& doService, uint8_t affinity, uint8_t priority, uint32_t period, const char* threadInfo) :
-        _doService(doService), _affinity(affinity), _priority(priority),_period(period),_semaphore(0), _isRunning(true), _threadInfo(threadInfo)
+    Service(T&& doService, uint8_t affinity, uint8_t priority, uint32_t period, const char* threadInfo, uint32_t wcetUs = 0) :
+        _doService(doService), _affinity(affinity), _priority(priority),_period(period),_minPeriod(period),_semaphore(0), _isRunning(true), _threadInfo(threadInfo),
+        _declaredWcet((uint64_t)wcetUs * 1000)
     {
         trace(__func__);
         // Start the service thread, which will begin running the given function immediately
@@ -62,29 +122,73 @@ public:
     {
         return _period;
     }
+
+    // Changed by the dispatcher in adaptive mode; takes effect from the next release
+    void setPeriod(uint32_t period)
+    {
+        _period = period;
+    }
+
+    // Shortest period the service may be given, for the schedulability check
+    uint32_t getMinPeriod() { return _minPeriod; }
+    void setMinPeriod(uint32_t period) { _minPeriod = period; }
+
+    uint8_t getAffinity() { return _affinity; }
+    uint8_t getPriority() { return _priority; }
+    const string& getName() { return _threadInfo; }
+
+    // Read once the service has stopped
+    uint64_t maxReleaseLatency()
+    {
+        return _releaseLatency.max();
+    }
+
+    // Worst case in ns, declared or measured so far; 0 if unknown. The wall
+    // time includes any blocking in the service (e.g. the SDR read), the CPU
+    // time is what it takes from lower-priority services on its CPU.
+    uint64_t wcet(bool measured) { return measured ? _runTime.max() : _declaredWcet; }
+    uint64_t cpuWcet(bool measured) { return measured ? _cpuTime.max() : _declaredWcet; }
  
     void stop()
     {
         // change state to "not running" using an atomic variable
         // (heads up: what if the service is waiting on the semaphore when this happens?)
         _isRunning = false;
-        this->release(); //(releases the blocked service in _provideService which is blocked on the binary semaphore (_semaphore.acquire))
+        //(releases the blocked service in _provideService which is blocked on the binary semaphore (_semaphore.acquire))
+        if (_pending.exchange(true) == false)
+        {
+            _semaphore.release();
+        }
     }
  
-    void release()
+    // 'releaseNs' is the CLOCK_MONOTONIC instant the release was due; the
+    // run's deadline is one period after it
+    void release(uint64_t releaseNs)
     {
         // todo(completed): release the service using the semaphore
+        // a binary semaphore cannot count a second release, so a release that
+        // finds the last one still waiting to start is dropped and counted
+        if (_pending.exchange(true) == true)
+        {
+            _skippedReleases++;
+            return;
+        }
+        _releaseNs = releaseNs;
         _semaphore.release(); // Release the semaphore (increment by 1)
     }
 
     void printStats()
     {
         std::cout<<"\n***Printing stats for "<<_threadInfo<<"***"<<std::endl;
-        std::cout<<"WCET: "<<_maxRunTime<<"ms"<<std::endl;
-        std::cout<<"Max runtime: "<<_maxRunTime<<"ms"<<std::endl;
-        std::cout<<"Min runtime: "<<_minRunTime<<"ms"<<std::endl;
-        std::cout<<"Avg runtime: "<<((double)_sumRunTime)/_runCount<<"ms"<<std::endl;
-        std::cout<<"Execution Time Jitter: "<<_maxRunTime-_minRunTime<<"ms"<<std::endl;
+        std::cout<<"Runs: "<<_runTime.count()<<", period "<<_period<<"ms"<<std::endl;
+        printLatency("Release latency", _releaseLatency);
+        printLatency("Runtime", _runTime);
+        printLatency("CPU time", _cpuTime);
+        std::cout<<"WCET: "<<_runTime.max() / 1000.0<<"us"<<std::endl;
+        std::cout<<"Execution Time Jitter: "<<(_runTime.max() - _runTime.min()) / 1000.0<<"us"<<std::endl;
+        std::cout<<"Overruns (runtime > period): "<<_overruns<<std::endl;
+        std::cout<<"Deadline misses (done > release + period): "<<_deadlineMisses<<std::endl;
+        std::cout<<"Releases skipped (previous one not started): "<<_skippedReleases<<std::endl;
     }
  
 private:
@@ -92,46 +196,36 @@ private:
     jthread _service;
     uint8_t _affinity;
     uint8_t _priority;
-    uint32_t _period;
+    atomic<uint32_t> _period;
+    uint32_t _minPeriod;
     binary_semaphore _semaphore;  // Start with no permit
     atomic<bool> _isRunning;
     string _threadInfo;
-
-    long int _maxRunTime = 0;
-    long int _minRunTime = UINT32_MAX;
-    long int _wcet = 0;
-    long int _sumRunTime;
-    uint32_t _runCount = 0;
+    uint64_t _declaredWcet;        // ns
+    atomic<bool> _pending{false};  // released and not yet started
+    atomic<uint64_t> _releaseNs{0};
+
+    // Written by the service thread only
+    LatencyHistogram _releaseLatency;  // due release to semaphore acquired, ns
+    LatencyHistogram _runTime;   // steady clock, ns
+    LatencyHistogram _cpuTime;   // CLOCK_THREAD_CPUTIME_ID, ns
+    uint64_t _overruns = 0;
+    uint64_t _deadlineMisses = 0;
+    atomic<uint64_t> _skippedReleases{0};
+
+    static uint64_t _threadCpuNs()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+        return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+    }
 
 
     void _initializeService()
     {
-        // (heads up: the thread is already running and we're in its context right now)
-        pthread_t native_handle = _service.native_handle();
-
-        cpu_set_t cpuset;
-        CPU_ZERO(&cpuset);
-        CPU_SET(_affinity, &cpuset);
-        if (pthread_setaffinity_np(native_handle, sizeof(cpu_set_t), &cpuset) != 0) {
-            std::cerr << "Failed to set CPU affinity\n";
-        }
-        else
-        {
-            //std::cout << "Affinity set success!\n";
-        }
-
-        struct sched_param param;
-        param.sched_priority = _priority;
-    
-        if (pthread_setschedparam(native_handle, SCHED_FIFO, &param) != 0) {
-            std::cerr << "Failed to set thread priority\n";
-        }
-        else
-        {
-            //std::cout << "Thread priority set success!\n";
-        }
-
-        pthread_setname_np(pthread_self(), _threadInfo.c_str());
+        // (heads up: the thread is already running and we're in its context right now,
+        // possibly before the constructor has stored it in _service)
+        configureThread(_affinity, _priority, _threadInfo.c_str());
     }
 
     void _provideService()
@@ -144,38 +238,35 @@ private:
         while(_isRunning == true)
         {
             _semaphore.acquire(); // Lock the semaphore (block until semaphore is not 1 and decrement from 1 to 0)
+            const uint64_t woke = monotonicNs();
 
             // check if i am still allowed to run?
             if (_isRunning == false)
             {
                 break;
             }
-#if 1
-            auto now_start = std::chrono::system_clock::now();
-            auto now_ms_start = std::chrono::duration_cast<std::chrono::milliseconds>(
-                                    now_start.time_since_epoch())
-                                    .count();
-            //syslog(LOG_INFO, "Starting service %s at time %ld ms", _threadInfo.c_str(), now_ms_start);
-#endif
+            // take the release time first: clearing _pending lets the next one in
+            const uint64_t releaseNs = _releaseNs;
+            const uint64_t period = (uint64_t)_period * 1000000ull;
+            const uint64_t deadline = releaseNs + period;
+            _pending = false;
+            _releaseLatency.add(woke > releaseNs ? woke - releaseNs : 0);
+
+            const uint64_t start = monotonicNs();
+            const uint64_t cpuStart = _threadCpuNs();
             _doService();
-#if 1
-            auto now_end = std::chrono::system_clock::now();
-            auto now_ms_end = std::chrono::duration_cast<std::chrono::milliseconds>(
-                                  now_end.time_since_epoch())
-                                  .count();
-            //syslog(LOG_INFO, "Stopping service %s at time %ld ms", _threadInfo.c_str(), now_ms_end);
-#endif
-            auto runtime = now_ms_end - now_ms_start;
-            _minRunTime = std::min(_minRunTime, runtime);
-            _maxRunTime = std::max(_maxRunTime, runtime);
-
-            _sumRunTime += runtime;
-            _runCount++;
+            const uint64_t cpuEnd = _threadCpuNs();
+            const uint64_t end = monotonicNs();
 
-            // edge case: zero out sum if count is going to wrap around to prevent error in avg calc
-            if (_runCount == UINT32_MAX)
+            _runTime.add(end - start);
+            _cpuTime.add(cpuEnd - cpuStart);
+            if (end - start > period)
+            {
+                _overruns++;
+            }
+            if (end > deadline)
             {
-                _sumRunTime = 0;
+                _deadlineMisses++;
             }
         }
     }
@@ -194,9 +285,20 @@ bool sorter(const std::unique_ptr<Service> &a, const std::unique_ptr<Service> &b
 // The sequencer class contains the services set and manages
 // starting/stopping the services. While the services are running,
 // the sequencer releases each service at the requisite timepoint.
+// Releases come from a dispatcher thread that sleeps with an absolute
+// CLOCK_MONOTONIC clock_nanosleep until the earliest next release, so there
+// is no periodic tick, no signal handler and no drift when NTP steps the
+// wall clock. Each service's release times are start + k * period.
 class Sequencer
 {
 public:
+    // The dispatcher must outrank every service on its CPU, or a long
+    // service run there would delay the releases of all the others
+    Sequencer(uint8_t affinity = 0, uint8_t priority = 99) :
+        _affinity(affinity), _priority(priority)
+    {
+    }
+
     template<typename... Args>
     void addService(Args&&... args)
     {
@@ -212,13 +314,24 @@ public:
         // todo(completed): start timer(s), release services
         trace(__func__);
 
-        timePoint++;
+        _isRunning = true;
+        _dispatcher = jthread(&Sequencer::_dispatch, this);
+    }
 
-        for (size_t i = 0; i < _services.size(); i++) 
+    // Adaptive mode for one service: at each of its releases the dispatcher
+    // reads 'depth', the blocks waiting in the service's input ring. Past
+    // ADAPT_BACKLOG it halves the period to catch up; on an empty ring it
+    // backs the period off by an eighth. The period stays within
+    // [minPeriod, maxPeriod] and every change goes to syslog. Call before
+    // startServices().
+    void adaptPeriod(const char* name, function<size_t(void)> depth, uint32_t minPeriod, uint32_t maxPeriod)
+    {
+        for (size_t i = 0; i < _services.size(); i++)
         {
-            if (timePoint % _services[i]->getPeriod() == 0)
+            if (_services[i]->getName() == name)
             {
-                _services[i]->release();  // Dereferencing unique_ptr
+                _services[i]->setMinPeriod(std::min(minPeriod, _services[i]->getPeriod()));
+                _adaptive.push_back({i, depth, minPeriod, maxPeriod, 0});
             }
         }
     }
@@ -227,52 +340,125 @@ public:
     {
         // todo(completed): stop timer(s), stop services
         trace(__func__);
+        // the dispatcher sees this when it next wakes, at most one period away
+        _isRunning = false;
         for (size_t i = 0; i < _services.size(); ++i) 
         {
             _services[i]->stop();  // Dereferencing unique_ptr
         }
-        stopTimer();
     }
 
     void printStatistics()
     {
         // todo(completed): stop timer(s), stop services
         trace(__func__);
+        std::cout<<"\n***Printing stats for dispatcher***"<<std::endl;
+        printLatency("Wake latency", _wakeLatency);
         for (size_t i = 0; i < _services.size(); ++i) 
         {
             _services[i]->printStats();  // Dereferencing unique_ptr
         }
+        for (auto& a: _adaptive)
+        {
+            std::cout<<"Adaptive "<<_services[a.service]->getName()<<": period now "
+                     <<_services[a.service]->getPeriod()<<"ms in ["<<a.minPeriod<<", "<<a.maxPeriod
+                     <<"], "<<a.adjustments<<" adjustments"<<std::endl;
+        }
     }
 
-    void initTimer(void (*callbackFunc)(int))
+    uint64_t maxReleaseLatency()
     {
-        struct sigevent sev{};
-        struct itimerspec its{};
-        //timer_t timerid;
-
-        sev.sigev_notify = SIGEV_SIGNAL;  // Notify using a signal
-        sev.sigev_signo = SIGALRM;        // Send SIGALRM when the timer expires
-        signal(SIGALRM, callbackFunc);  // Register handler for SIGALRM
-
-        timer_create(CLOCK_REALTIME, &sev, &timerid);
-
-        uint32_t interval_ms = 1;
-        its.it_value.tv_sec = interval_ms / 1000;
-        its.it_value.tv_nsec = (interval_ms % 1000) * 1000000;
-        its.it_interval = its.it_value; // set interval to same interval_ms
-
-        if (timer_settime(timerid, 0, &its, nullptr) == -1) {
-            std::cerr << "Failed to start timer!\n";
+        uint64_t worst = 0;
+        for (auto& s: _services)
+        {
+            worst = std::max(worst, s->maxReleaseLatency());
         }
+        return worst;
     }
 
-    void stopTimer()
+    // Response-time analysis of the service set under partitioned SCHED_FIFO:
+    // a service only competes with services pinned to the same CPU, and
+    // every one there at an equal or higher priority (equal ones are FIFO,
+    // so they may go first) preempts it. Worst-case response R solves
+    //     R = C + sum over those services j of ceil(R / T_j) * Cpu_j
+    // with each deadline equal to the period. Uses declared WCETs, or the
+    // worst runtimes measured so far when 'measured' is set. Prints per-CPU
+    // utilization and each response time; false if any deadline can be
+    // missed. Services with no WCET are reported and left out. Adaptive
+    // services are checked at their shortest period, their worst case.
+    bool analyze(bool measured)
     {
-        struct itimerspec its{};
-        if (timer_settime(timerid, 0, &its, nullptr) == -1)
+        bool schedulable = true;
+        vector<uint8_t> cpus;
+        for (auto& s: _services)
         {
-            std::cerr << "Failed to stop timer!\n";
+            if (std::find(cpus.begin(), cpus.end(), s->getAffinity()) == cpus.end())
+            {
+                cpus.push_back(s->getAffinity());
+            }
+        }
+        std::sort(cpus.begin(), cpus.end());
+
+        std::cout<<"\n***Schedulability ("<<(measured ? "measured" : "declared")<<" WCET)***"<<std::endl;
+        for (uint8_t cpu: cpus)
+        {
+            double utilization = 0;
+            for (auto& s: _services)
+            {
+                if (s->getAffinity() == cpu)
+                {
+                    utilization += (double)s->cpuWcet(measured) / ((uint64_t)s->getMinPeriod() * 1000000ull);
+                }
+            }
+            printf("CPU %u: utilization %.1f%%%s\n", cpu, utilization * 100,
+                   utilization > 1.0 ? ", OVERLOADED" : "");
+            if (utilization > 1.0)
+            {
+                schedulable = false;
+            }
+
+            for (auto& s: _services)
+            {
+                if (s->getAffinity() != cpu)
+                {
+                    continue;
+                }
+                const uint64_t deadline = (uint64_t)s->getMinPeriod() * 1000000ull;
+                const uint64_t c = s->wcet(measured);
+                if (c == 0)
+                {
+                    printf("  %-16s prio %2u T %5ums  WCET unknown\n", s->getName().c_str(),
+                           s->getPriority(), s->getMinPeriod());
+                    continue;
+                }
+
+                uint64_t r = c;
+                while (r <= deadline)
+                {
+                    uint64_t next = c;
+                    for (auto& j: _services)
+                    {
+                        if (j != s && j->getAffinity() == cpu && j->getPriority() >= s->getPriority())
+                        {
+                            const uint64_t t = (uint64_t)j->getMinPeriod() * 1000000ull;
+                            next += (r + t - 1) / t * j->cpuWcet(measured);
+                        }
+                    }
+                    if (next == r)
+                    {
+                        break;
+                    }
+                    r = next;
+                }
+
+                const bool ok = r <= deadline;
+                printf("  %-16s prio %2u T %5ums  C %9.3fms  R %s%9.3fms  %s\n", s->getName().c_str(),
+                       s->getPriority(), s->getMinPeriod(), c / 1e6, ok ? "" : ">", r / 1e6,
+                       ok ? "ok" : "MISSES DEADLINE");
+                schedulable = schedulable && ok;
+            }
         }
+        return schedulable;
     }
 
     void sortService()
@@ -285,7 +471,99 @@ public:
         }    
     }
 private:
+    static constexpr size_t ADAPT_BACKLOG = 2;  // blocks queued before speeding up
+
+    struct AdaptiveRate
+    {
+        size_t service;
+        function<size_t(void)> depth;
+        uint32_t minPeriod;
+        uint32_t maxPeriod;
+        uint64_t adjustments;
+    };
+
     vector<unique_ptr<Service>> _services;
-    uint32_t timePoint = 0;
-    timer_t timerid;
+    vector<AdaptiveRate> _adaptive;
+    uint8_t _affinity;
+    uint8_t _priority;
+    atomic<bool> _isRunning{false};
+    LatencyHistogram _wakeLatency;  // clock_nanosleep deadline to return, ns
+    jthread _dispatcher;  // declared last so it is joined before _services goes away
+
+    void _adapt(size_t service)
+    {
+        for (auto& a: _adaptive)
+        {
+            if (a.service != service)
+            {
+                continue;
+            }
+            const size_t depth = a.depth();
+            const uint32_t period = _services[service]->getPeriod();
+            uint32_t next = period;
+            if (depth > ADAPT_BACKLOG)
+            {
+                next = std::max(a.minPeriod, period / 2);
+            }
+            else if (depth == 0)
+            {
+                next = std::min(a.maxPeriod, period + std::max(1u, period / 8));
+            }
+            if (next != period)
+            {
+                _services[service]->setPeriod(next);
+                a.adjustments++;
+                syslog(LOG_INFO, "%s: period %u -> %u ms, %zu blocks queued",
+                       _services[service]->getName().c_str(), period, next, depth);
+            }
+        }
+    }
+
+    void _dispatch()
+    {
+        configureThread(_affinity, _priority, "dispatcher");
+        if (_services.empty())
+        {
+            return;
+        }
+
+        // every service is first released at 'start', then once per period
+        const uint64_t start = monotonicNs();
+        vector<uint64_t> next(_services.size(), start);
+
+        while (_isRunning == true)
+        {
+            uint64_t wake = *std::min_element(next.begin(), next.end());
+            struct timespec ts = toTimespec(wake);
+            while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR)
+            {
+            }
+
+            if (_isRunning == false)
+            {
+                break;
+            }
+
+            const uint64_t now = monotonicNs();
+            _wakeLatency.add(now > wake ? now - wake : 0);
+            for (size_t i = 0; i < _services.size(); i++)
+            {
+                if (next[i] > wake)
+                {
+                    continue;
+                }
+                _adapt(i);
+                _services[i]->release(wake);
+
+                // if the dispatcher itself was held off past whole periods,
+                // skip those releases rather than firing them back to back
+                const uint64_t period = (uint64_t)_services[i]->getPeriod() * 1000000ull;
+                next[i] += period;
+                if (next[i] <= now)
+                {
+                    next[i] += (now - next[i]) / period * period + period;
+                }
+            }
+        }
+    }
 };
@@ -43,6 +43,9 @@ static pthread_t blkth_id;
 
 static int acars_shutdown;
 
+/* messages handed to outputmsg() by blk_thread_serial() */
+unsigned long acarsMessageCount = 0;
+
 #include "syndrom.h"
 
 static int fixprerr(msgblk_t * blk, const unsigned short crc, int *pr, int pn)
@@ -338,6 +341,7 @@ void blk_thread_serial()
 			return;
 		}
 
+		__atomic_fetch_add(&acarsMessageCount, 1, __ATOMIC_RELAXED);
 		outputmsg(blk);
 
 		free(blk);
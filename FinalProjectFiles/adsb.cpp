@@ -19,44 +19,10 @@
 #include <unordered_map>
 #include <sys/time.h>
 #include <stdio.h>
-
-/*******************************************************************************
- * The following table has been imported from the dum1090 library:
- * https://github.com/antirez/dump1090
-********************************************************************************/
-/* Parity table for MODE S Messages.
- * The table contains 112 elements, every element corresponds to a bit set
- * in the message, starting from the first bit of actual data after the
- * preamble.
- *
- * For messages of 112 bit, the whole table is used.
- * For messages of 56 bits only the last 56 elements are used.
- *
- * The algorithm is as simple as xoring all the elements in this table
- * for which the corresponding bit on the message is set to 1.
- *
- * The latest 24 elements in this table are set to 0 as the checksum at the
- * end of the message should not affect the computation.
- *
- * Note: this function can be used with DF11 and DF17, other modes have
- * the CRC xored with the sender address as they are reply to interrogations,
- * but a casual listener can't split the address from the checksum.
- */
-uint32_t modes_checksum_table[112] = {
-   0x3935ea, 0x1c9af5, 0xf1b77e, 0x78dbbf, 0xc397db, 0x9e31e9, 0xb0e2f0, 0x587178,
-   0x2c38bc, 0x161c5e, 0x0b0e2f, 0xfa7d13, 0x82c48d, 0xbe9842, 0x5f4c21, 0xd05c14,
-   0x682e0a, 0x341705, 0xe5f186, 0x72f8c3, 0xc68665, 0x9cb936, 0x4e5c9b, 0xd8d449,
-   0x939020, 0x49c810, 0x24e408, 0x127204, 0x093902, 0x049c81, 0xfdb444, 0x7eda22,
-   0x3f6d11, 0xe04c8c, 0x702646, 0x381323, 0xe3f395, 0x8e03ce, 0x4701e7, 0xdc7af7,
-   0x91c77f, 0xb719bb, 0xa476d9, 0xadc168, 0x56e0b4, 0x2b705a, 0x15b82d, 0xf52612,
-   0x7a9309, 0xc2b380, 0x6159c0, 0x30ace0, 0x185670, 0x0c2b38, 0x06159c, 0x030ace,
-   0x018567, 0xff38b7, 0x80665f, 0xbfc92b, 0xa01e91, 0xaff54c, 0x57faa6, 0x2bfd53,
-   0xea04ad, 0x8af852, 0x457c29, 0xdd4410, 0x6ea208, 0x375104, 0x1ba882, 0x0dd441,
-   0xf91024, 0x7c8812, 0x3e4409, 0xe0d800, 0x706c00, 0x383600, 0x1c1b00, 0x0e0d80,
-   0x0706c0, 0x038360, 0x01c1b0, 0x00e0d8, 0x00706c, 0x003836, 0x001c1b, 0xfff409,
-   0x000000, 0x000000, 0x000000, 0x000000, 0x000000, 0x000000, 0x000000, 0x000000,
-   0x000000, 0x000000, 0x000000, 0x000000, 0x000000, 0x000000, 0x000000, 0x000000,
-   0x000000, 0x000000, 0x000000, 0x000000, 0x000000, 0x000000, 0x000000, 0x000000};
+#include <string.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
 
 /*******************************************************************************
  * The following function has been imported from the dump1090 library:
@@ -80,8 +46,7 @@ RtlSdr::RtlSdr()
 {
    if (rtlsdr_open(&dev, 0) < 0)
    {
-      perror("Error opening the RTLSDR device");
-      exit(1);
+      throw std::runtime_error("Error opening the RTLSDR device");
    }
 
    int gains[100];
@@ -109,10 +74,18 @@ RtlSdr::RtlSdr()
            rtlsdr_get_tuner_gain(dev) / 10.0);
 }
 
+/* ~SampleSource() would only reach the base stopStreaming(), which joins
+ * the async thread without cancelling rtlsdr_read_async, so it never
+ * returns. */
+RtlSdr::~RtlSdr()
+{
+   stopStreaming();
+}
+
 /*******************************************************************************
  * Reference:https://github.com/librtlsdr/librtlsdr
 ********************************************************************************/
-int RtlSdr::readSdr(const uint32_t frequency, uint8_t *buffer, uint32_t length)
+int RtlSdr::read(const uint32_t frequency, uint8_t *buffer, uint32_t length)
 {
    //std::lock_guard<std::mutex> lock(rtlSdr_Mutex);
    if (buffer == nullptr)
@@ -120,13 +93,30 @@ int RtlSdr::readSdr(const uint32_t frequency, uint8_t *buffer, uint32_t length)
       perror("buffer null\n");
    }
 
-   rtlsdr_set_center_freq(dev, frequency);
+   // the dongle keeps sampling between reads, and nothing keeps those
+   auto begin = std::chrono::steady_clock::now();
+   uint64_t idleUs = std::chrono::duration_cast<std::chrono::microseconds>(begin - _readEnd).count();
+   _skipped = 0;
+   if (_readEnd.time_since_epoch().count() != 0 && idleUs > RTL_READ_SLACK_US)
+   {
+      _skipped = idleUs * MODES_DEFAULT_RATE / 1000000;
+   }
+
+   // Retune only on a band change; a retune costs the tuner PLL settle time
+   if (frequency != _tunedFrequency)
+   {
+      rtlsdr_set_center_freq(dev, frequency);
+      rtlsdr_reset_buffer(dev);
+      _tunedFrequency = frequency;
+   }
 
    //how many bytes were actually read from hardware
    int n_read;
 
    // Blocking read
-   if (rtlsdr_read_sync(dev, buffer, length, &n_read) < 0)
+   int status = rtlsdr_read_sync(dev, buffer, length, &n_read);
+   _readEnd = std::chrono::steady_clock::now();
+   if (status < 0)
    {
       perror("SDR Read failed\n");
       return -1;
@@ -136,9 +126,111 @@ int RtlSdr::readSdr(const uint32_t frequency, uint8_t *buffer, uint32_t length)
 
 void RtlSdr::closeSdr()
 {
+   stopStreaming();
    rtlsdr_close(dev);
 }
 
+bool RtlSdr::startStreaming(const uint32_t frequency, CircularBuffer *ring)
+{
+   if (ring == nullptr || _streaming)
+   {
+      return false;
+   }
+
+   rtlsdr_set_center_freq(dev, frequency);
+   rtlsdr_reset_buffer(dev);
+   _tunedFrequency = frequency;
+
+   _streamRing = ring;
+   _streamPosition = 0;
+   _streamFrequency = frequency;
+   _streaming = true;
+
+   // rtlsdr_read_async blocks until rtlsdr_cancel_async, so it gets its own thread
+   const uint32_t blockSize = ring->blockSize();
+   _streamThread = std::thread([this, blockSize]() {
+      pthread_setname_np(pthread_self(), "rtlsdr async");
+      if (rtlsdr_read_async(dev, &RtlSdr::_asyncCallback, this,
+                            RTL_ASYNC_BUF_NUM, blockSize) < 0)
+      {
+         perror("rtlsdr_read_async failed");
+      }
+      _streaming = false;
+   });
+   return true;
+}
+
+void RtlSdr::stopStreaming()
+{
+   if (_streamThread.joinable() == false)
+   {
+      return;
+   }
+   rtlsdr_cancel_async(dev);
+   _streamThread.join();
+   _streaming = false;
+}
+
+void RtlSdr::_asyncCallback(unsigned char *buffer, uint32_t length, void *ctx)
+{
+   static_cast<RtlSdr *>(ctx)->_onTransfer(buffer, length);
+}
+
+/* Runs on the libusb event thread. librtlsdr resubmits the transfer as soon
+ * as we return, so the block has to be in the ring before then. */
+void RtlSdr::_onTransfer(unsigned char *buffer, uint32_t length)
+{
+   const uint64_t samples = length / 2;
+   const uint64_t inFlight = (uint64_t)RTL_ASYNC_BUF_NUM * (_streamRing->blockSize() / 2);
+   auto now = std::chrono::steady_clock::now();
+
+   if (_transfers == 0)
+   {
+      // the first transfer was captured before we got to see it
+      _streamStart = now - std::chrono::microseconds(samples * 1000000 / MODES_DEFAULT_RATE);
+   }
+
+   /* If the dongle is further behind the wall clock than every transfer
+    * we keep queued could hold, plus what its crystal may have drifted,
+    * those samples were lost on the USB side. Skip the stream position
+    * forward so consumers see the discontinuity, and start measuring again
+    * from here, so a slow crystal costs one gap and not one per transfer. */
+   uint64_t elapsedUs = std::chrono::duration_cast<std::chrono::microseconds>(now - _streamStart).count();
+   uint64_t expected = elapsedUs * MODES_DEFAULT_RATE / 1000000;
+   uint64_t drift = expected / 1000000 * RTL_DRIFT_PPM;
+   if (expected > _streamPosition + samples + inFlight + drift)
+   {
+      uint64_t missed = expected - (_streamPosition + samples + inFlight);
+      _samplesMissed += missed;
+      _streamPosition += missed;
+      _gaps++;
+      _streamStart = now - std::chrono::microseconds((_streamPosition + samples) * 1000000 / MODES_DEFAULT_RATE);
+
+      // at most one warning a second, however often the USB side drops
+      _gapsUnlogged++;
+      _missedUnlogged += missed;
+      if (now - _gapLogged >= std::chrono::seconds(1))
+      {
+         syslog(LOG_WARNING, "rtlsdr stream gap: %lu samples missed in %lu gaps",
+                (unsigned long)_missedUnlogged, (unsigned long)_gapsUnlogged);
+         _gapLogged = now;
+         _gapsUnlogged = 0;
+         _missedUnlogged = 0;
+      }
+   }
+
+   _deliver(_streamRing, buffer, length);
+}
+
+void RtlSdr::printStats()
+{
+   SampleSource::printStats();
+   if (_transfers != 0)
+   {
+      std::cout << "Samples missed (USB): " << _samplesMissed << std::endl;
+   }
+}
+
 Plotter::Plotter()
 {
    _mapTex.loadFromFile("map.png");
@@ -152,7 +244,7 @@ Plotter::Plotter()
 /******************************************************************************
  * Reference: https://github.com/SFML/SFML
 ******************************************************************************/
-void Plotter::plotAircrafts(const std::unordered_map<uint32_t, Aircraft> &aircrafts)
+void Plotter::plotAircrafts(const std::vector<Aircraft> &aircrafts)
 {
    if (_windowInit == false)
    {
@@ -168,7 +260,7 @@ void Plotter::plotAircrafts(const std::unordered_map<uint32_t, Aircraft> &aircra
    //  Render
    _window.clear();
    _window.draw(_mapSprite);
-   for (auto &[_, a] : aircrafts)
+   for (auto &a : aircrafts)
    {
       if (a.lat == 0.0 || a.lon == 0.0) //Skips aircraft with invalid positions.
       {
@@ -194,33 +286,124 @@ void Plotter::close()
  * Reference: https://github.com/antirez/dump1090
 ******************************************************************************/
 Adsb::Adsb()
+    : _magnitude(&bestMagnitudeKernel()), _preamble(&bestPreambleKernel()), _slice(&bestSliceKernel()),
+      _crc(&bestCrcKernel())
 {
-   /* Populate the I/Q -> Magnitude lookup table. It is used because
-    * sqrt or round may be expensive and performance may vary a lot
-    * depending on the libc used.
-    *
-    * Note that we don't need to fill the table for negative values, as
-    * we square both i and q to take the magnitude. So the maximum absolute
-    * value of i and q is 128, thus the maximum magnitude we get is:
-    *
-    * sqrt(128*128+128*128) = ~181.02
-    *
-    * Then, to retain the full resolution and be able to distinguish among
-    * every pair of I/Q values, we scale this range from the float range
-    * 0-181 to the uint16_t range of 0-65536 by multiplying for 360. */
-   for (int i = 0; i <= 128; i++)
+   syslog(LOG_INFO, "ADS-B kernels: magnitude %s, preamble %s, slice %s, crc %s", _magnitude->name,
+          _preamble->name, _slice->name, _crc->name);
+}
+
+/* Last-level cache misses of the calling thread so far, from a hardware
+ * counter opened on the first call; false if the CPU or kernel has none
+ * (VMs, perf_event_paranoid > 2). */
+static bool readCacheMisses(int &fd, uint64_t &misses)
+{
+   if (fd == -2)
    {
-      for (int q = 0; q <= 128; q++)
+      struct perf_event_attr attr;
+      memset(&attr, 0, sizeof(attr));
+      attr.size = sizeof(attr);
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.config = PERF_COUNT_HW_CACHE_MISSES;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+      if (fd < 0)
       {
-         _magnitudeLookupTable[i][q] = round(sqrt(i * i + q * q) * 360);
+         syslog(LOG_INFO, "ADS-B: no cache miss counter: %s", strerror(errno));
+         fd = -1;
       }
    }
+   return fd >= 0 && read(fd, &misses, sizeof(misses)) == sizeof(misses);
 }
 
-void Adsb::processData(uint8_t *buffer, uint32_t length)
+void Adsb::processData(uint8_t *buffer, uint32_t length, uint64_t sampleIndex)
 {
-   _computeMagnitudeVector(buffer, length);
-   detectModeS(length); //finds aircrafts
+   uint64_t missesBefore = 0;
+   const bool counted = readCacheMisses(_missCounter, missesBefore);
+   const auto start = std::chrono::steady_clock::now();
+
+   /* The tail of the previous block is already at the front of the vector;
+    * keep it only if this block carries straight on from it. */
+   uint32_t seam = 0;
+   uint32_t from = 0;
+   if (sampleIndex == _nextSampleIndex && _carried > 0)
+   {
+      seam = _carried;
+      from = _carryResume;
+   }
+
+   const uint32_t samples = length / 2; /* one sample per I/Q pair */
+   _streamSeconds = sampleIndex / MODES_DEFAULT_RATE;
+   const uint32_t tile = (_tileSamples > 0 && _segmentFrames.size() == 1) ? _tileSamples : samples;
+   for (uint32_t done = 0; done < samples; done += tile)
+   {
+      const uint32_t n = std::min(tile, samples - done);
+      _computeMagnitudeVector(buffer + 2 * done, 2 * n, _magnitudeVector + seam);
+      detectModeS(seam + n, from, done == 0 ? seam : 0); //finds aircrafts
+      seam = _carried;
+      from = _carryResume;
+   }
+   _nextSampleIndex = sampleIndex + samples;
+
+   _demodBlocks++;
+   _demodNs += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+   uint64_t missesAfter = 0;
+   if (counted && readCacheMisses(_missCounter, missesAfter))
+   {
+      _cacheMisses += missesAfter - missesBefore;
+   }
+}
+
+void Adsb::setDemodSegments(size_t segments, std::function<void(size_t worker)> setup)
+{
+   _workers.reset();
+   if (segments > 1)
+   {
+      _workers = std::make_unique<WorkerPool>(segments, std::move(setup));
+   }
+   _segmentFrames.resize(std::max<size_t>(segments, 1));
+}
+
+void Adsb::printStats()
+{
+   std::cout << "\n***Printing stats for ADS-B decoder***" << std::endl;
+   std::cout << "Mode S frames with good CRC: " << _framesDecoded << std::endl;
+   std::cout << "Of which repaired: " << _oneBitFixes << " one bit, " << _twoBitFixes << " two bit" << std::endl;
+   std::cout << "DF17 frames: " << df17Frames() << std::endl;
+   std::cout << "Address/Parity frames from known aircraft: " << _apFrames << std::endl;
+   std::cout << "Positions decoded: " << _positionsDecoded << std::endl;
+   std::cout << "Frames across block seams: " << _seamFrames << std::endl;
+   std::cout << "Kernels: magnitude " << _magnitude->name << ", preamble " << _preamble->name << ", slice "
+             << _slice->name << ", crc " << _crc->name << std::endl;
+   if (_demodBlocks > 0)
+   {
+      std::cout << "Demodulation: " << _demodNs / 1000.0 / _demodBlocks << "us per block, ";
+      if (_tileSamples > 0 && _segmentFrames.size() == 1)
+      {
+         std::cout << "fused in tiles of " << _tileSamples << " samples" << std::endl;
+      }
+      else
+      {
+         std::cout << "whole blocks" << std::endl;
+      }
+   }
+   if (_missCounter >= 0 && _framesDecoded > 0)
+   {
+      std::cout << "Cache misses on the demod thread: " << _cacheMisses * CACHE_LINE / _framesDecoded
+                << " bytes per decoded frame (" << _cacheMisses * CACHE_LINE / std::max<uint64_t>(_demodBlocks, 1)
+                << " per block)" << std::endl;
+   }
+   else
+   {
+      std::cout << "Cache misses on the demod thread: no hardware counter" << std::endl;
+   }
+   if (_workers)
+   {
+      std::cout << "Demod segments: " << _workers->size() << ", frames found twice in overlaps: "
+                << _overlapDuplicates << std::endl;
+   }
+   std::cout << "Aircraft tracked: " << _aircrafts.size() << std::endl;
 }
 
 void Adsb::removeAircrafts()
@@ -242,6 +425,17 @@ const std::unordered_map<uint32_t, Aircraft> &Adsb::getAircrafts()
    return _aircrafts;
 }
 
+std::vector<Aircraft> Adsb::snapshot()
+{
+   std::vector<Aircraft> aircrafts;
+   aircrafts.reserve(_aircrafts.size());
+   for (auto &[_, a] : _aircrafts)
+   {
+      aircrafts.push_back(a);
+   }
+   return aircrafts;
+}
+
 void Adsb::printAircrafts()
 {
    for (const auto &[icao_addr, aircraft] : _aircrafts)
@@ -249,6 +443,7 @@ void Adsb::printAircrafts()
       printf("X-----------------------------------------------------X\n");
       printf("    ICAO Addr : %x \n", icao_addr);
       printf("    Altitude : %d feet\n", aircraft.altitude);
+      printf("    Squawk   : %04d\n", aircraft.squawk);
       printf("    Latitude : %f \n", aircraft.lat);
       printf("    Longitude: %f \n", aircraft.lon);
    }
@@ -258,27 +453,12 @@ void Adsb::printAircrafts()
  * Reference: https://github.com/antirez/dump1090
 ******************************************************************************/
 /* Turn I/Q samples pointed in the buffer into the magnitude vector */
-void Adsb::_computeMagnitudeVector(uint8_t *buffer, uint32_t length)
+void Adsb::_computeMagnitudeVector(uint8_t *buffer, uint32_t length, uint16_t *out)
 {
    /* Compute the magnitudo vector. It's just SQRT(I^2 + Q^2), but
-    * we rescale to the 0-255 range to exploit the full resolution. */
-   uint32_t magnitudeIter = 0;
-   for (uint32_t j = 0; j < length; j += 2)
-   {
-      int i = buffer[j] - 127;
-      int q = buffer[j + 1] - 127;
-
-      if (i < 0)
-      {
-         i = -i;
-      }
-      if (q < 0)
-      {
-         q = -q;
-      }
-
-      _magnitudeVector[magnitudeIter++] = _magnitudeLookupTable[i][q];
-   }
+    * we rescale to the 0-255 range to exploit the full resolution.
+    * See modesdsp.cpp for the lookup table and the SIMD versions. */
+   _magnitude->fn(buffer, length / 2, out);
 }
 
 /******************************************************************************
@@ -290,7 +470,7 @@ void Adsb::_computeMagnitudeVector(uint8_t *buffer, uint32_t length)
  *
  * Note: this function will access m[-1], so the caller should make sure to
  * call it only if we are not at the start of the current buffer. */
-int Adsb::detectOutOfPhase(uint16_t *m)
+int Adsb::detectOutOfPhase(const uint16_t *m)
 {
    if (m[3] > m[2] / 3)
       return 1;
@@ -369,89 +549,6 @@ int Adsb::modesMessageLenByType(int type)
       return MODES_SHORT_MSG_BITS;
 }
 
-uint32_t Adsb::modesChecksum(unsigned char *msg, int bits)
-{
-   uint32_t crc = 0;
-   int offset = (bits == 112) ? 0 : (112 - 56);
-   int j;
-
-   for (j = 0; j < bits; j++)
-   {
-      int byte = j / 8;
-      int bit = j % 8;
-      int bitmask = 1 << (7 - bit);
-
-      /* If bit is set, xor with corresponding table entry. */
-      if (msg[byte] & bitmask)
-         crc ^= modes_checksum_table[j + offset];
-   }
-   return crc; /* 24 bit checksum. */
-}
-
-/******************************************************************************
- * Reference: https://github.com/antirez/dump1090
-******************************************************************************/
-/* Decode the 12 bit AC altitude field (in DF 17 and others).
- * Returns the altitude or 0 if it can't be decoded. */
-int Adsb::decodeAC12Field(unsigned char *msg, int *unit)
-{
-   int q_bit = msg[5] & 1;
-
-   if (q_bit)
-   {
-      /* N is the 11 bit integer resulting from the removal of bit
-       * Q */
-      *unit = MODES_UNIT_FEET;
-      int n = ((msg[5] >> 1) << 4) | ((msg[6] & 0xF0) >> 4);
-      /* The final altitude is due to the resulting number multiplied
-       * by 25, minus 1000. */
-      return n * 25 - 1000;
-   }
-   else
-   {
-      return 0;
-   }
-}
-
-/******************************************************************************
- * Reference: https://github.com/antirez/dump1090
-******************************************************************************/
-/* Decode the 13 bit AC altitude field (in DF 20 and others).
- * Returns the altitude, and set 'unit' to either MODES_UNIT_METERS
- * or MDOES_UNIT_FEETS. */
-int Adsb::decodeAC13Field(unsigned char *msg, int *unit)
-{
-   int m_bit = msg[3] & (1 << 6);
-   int q_bit = msg[3] & (1 << 4);
-
-   if (!m_bit)
-   {
-      *unit = MODES_UNIT_FEET;
-      if (q_bit)
-      {
-         /* N is the 11 bit integer resulting from the removal of bit
-          * Q and M */
-         int n = ((msg[2] & 31) << 6) |
-                 ((msg[3] & 0x80) >> 2) |
-                 ((msg[3] & 0x20) >> 1) |
-                 (msg[3] & 15);
-         /* The final altitude is due to the resulting number multiplied
-          * by 25, minus 1000. */
-         return n * 25 - 1000;
-      }
-      else
-      {
-         /* TODO: Implement altitude where Q=0 and M=0 */
-      }
-   }
-   else
-   {
-      *unit = MODES_UNIT_METERS;
-      /* TODO: Implement altitude when meter unit is selected. */
-   }
-   return 0;
-}
-
 /******************************************************************************
  * Reference: https://github.com/antirez/dump1090
 ******************************************************************************/
@@ -620,7 +717,7 @@ double Adsb::cprDlonFunction(double lat, int isodd)
  *    simplicity. This may provide a position that is less fresh of a few
  *    seconds.
  */
-void Adsb::decodeCPR(Aircraft *a)
+bool Adsb::decodeCPR(Aircraft *a)
 {
    const double AirDlat0 = 360.0 / 60;
    const double AirDlat1 = 360.0 / 59;
@@ -641,7 +738,7 @@ void Adsb::decodeCPR(Aircraft *a)
 
    /* Check that both are in the same latitude zone, or abort. */
    if (cprNLFunction(rlat0) != cprNLFunction(rlat1))
-      return;
+      return false;
 
    /* Compute ni and the longitude index m */
    if (a->even_cprtime > a->odd_cprtime)
@@ -670,140 +767,109 @@ void Adsb::decodeCPR(Aircraft *a)
    {
       a->lon -= 360;
    }
+   return true;
+}
+
+/* Check the parity of a frame demodulated by detectModeS(). DF11 and DF17
+ * carry a plain CRC, which may be repaired; the other formats with a parity
+ * field XOR the sender's address into it, so for a clean one the syndrome
+ * is the address, accepted if that address was heard from in a clean DF11
+ * or DF17 in the last minute (a zero syndrome on its own means nothing
+ * there). 'frame' gets the bytes, repaired if they were, either way. */
+bool Adsb::checkModesFrame(const unsigned char *msg, ModesFrame &frame)
+{
+   unsigned char bytes[MODES_LONG_MSG_BYTES];
+   memcpy(bytes, msg, sizeof(bytes));
+
+   const int msgtype = bytes[0] >> 3;
+   const int msgbits = modesMessageLenByType(msgtype);
+   const int n = msgbits / 8;
+   const uint32_t parity = ((uint32_t)bytes[n - 3] << 16) | ((uint32_t)bytes[n - 2] << 8) | bytes[n - 1];
+   const uint32_t syndrome = parity ^ _crc->fn(bytes, msgbits);
+
+   uint32_t icao = ((uint32_t)bytes[1] << 16) | ((uint32_t)bytes[2] << 8) | bytes[3];
+   int errorbit = -1;
+   int errorbit2 = -1;
+   bool ok = syndrome == 0;
+
+   /* The syndrome of a frame with one or two flipped bits depends only on
+    * which bits they are, so they are looked up in a table of all of them
+    * (see modescrc.cpp) instead of flipping each bit and recomputing. */
+   if (!ok && _fixBits > 0 && (msgtype == 11 || msgtype == 17))
+   {
+      int positions[2];
+      int count = modesErrorBits(syndrome, msgbits, positions);
+      if (count == 1 || (count == 2 && _fixBits >= 2 && msgtype == 17))
+      {
+         for (int k = 0; k < count; k++)
+         {
+            bytes[positions[k] / 8] ^= 1 << (7 - positions[k] % 8);
+         }
+         errorbit = positions[0];
+         errorbit2 = count == 2 ? positions[1] : -1;
+         icao = ((uint32_t)bytes[1] << 16) | ((uint32_t)bytes[2] << 8) | bytes[3];
+         ok = true;
+      }
+   }
+
+   if (msgtype == 0 || msgtype == 4 || msgtype == 5 ||
+       msgtype == 16 || msgtype == 20 || msgtype == 21)
+   {
+      ok = _icaoCache.seen(syndrome, _streamSeconds);
+      if (ok)
+      {
+         icao = syndrome;
+      }
+   }
+
+   frame = ModesFrame(bytes, icao, errorbit, errorbit2);
+   return ok;
 }
 
 /* Decode a raw Mode S message demodulated as a stream of bytes by
  * detectModeS(), and split it into fields populating a modesMessage
- * structure. */
+ * structure. The demodulator and the tracker only check the frame and read
+ * the fields they need from the ModesFrame; this is for display. */
 void Adsb::decodeModesMessage(struct modesMessage *mm, unsigned char *msg)
 {
-   uint32_t crc2; /* Computed CRC, used to verify the message CRC. */
-   const char *ais_charset = "?ABCDEFGHIJKLMNOPQRSTUVWXYZ????? ???????????????0123456789??????";
+   ModesFrame frame;
+   mm->crcok = checkModesFrame(msg, frame);
 
-   /* Work on our local copy */
-   memcpy(mm->msg, msg, MODES_LONG_MSG_BYTES);
+   /* Work on our local copy, with any bit errors fixed */
+   memcpy(mm->msg, frame.data(), MODES_LONG_MSG_BYTES);
    msg = mm->msg;
 
-   /* Get the message type ASAP as other operations depend on this */
-   mm->msgtype = msg[0] >> 3; /* Downlink Format */
-   mm->msgbits = modesMessageLenByType(mm->msgtype);
+   mm->msgtype = frame.df(); /* Downlink Format */
+   mm->msgbits = frame.bits();
 
    /* CRC is always the last three bytes. */
-   mm->crc = ((uint32_t)msg[(mm->msgbits / 8) - 3] << 16) |
-             ((uint32_t)msg[(mm->msgbits / 8) - 2] << 8) |
-             (uint32_t)msg[(mm->msgbits / 8) - 1];
-   crc2 = modesChecksum(msg, mm->msgbits);
-
-   /* Check CRC and fix single bit errors using the CRC when
-    * possible (DF 11 and 17). */
-   mm->errorbit = -1; /* No error */
-   mm->crcok = (mm->crc == crc2);
-
-#if 0
-      if (!mm->crcok && Modes.fix_errors &&
-          (mm->msgtype == 11 || mm->msgtype == 17))
-      {
-         if ((mm->errorbit = fixSingleBitErrors(msg, mm->msgbits)) != -1)
-         {
-            mm->crc = modesChecksum(msg, mm->msgbits);
-            mm->crcok = 1;
-         }
-         else if (Modes.aggressive && mm->msgtype == 17 &&
-                  (mm->errorbit = fixTwoBitsErrors(msg, mm->msgbits)) != -1)
-         {
-            mm->crc = modesChecksum(msg, mm->msgbits);
-            mm->crcok = 1;
-         }
-      }
+   mm->crc = frame.parity();
+   mm->errorbit = frame.errorbit();
+   mm->errorbit2 = frame.errorbit2();
 
-#endif
-   /* Note that most of the other computation happens *after* we fix
-    * the single bit errors, otherwise we would need to recompute the
-    * fields again. */
-   mm->ca = msg[0] & 7; /* Responder capabilities. */
+   mm->ca = frame.ca(); /* Responder capabilities. */
 
-   /* ICAO address */
-   mm->aa1 = msg[1];
-   mm->aa2 = msg[2];
-   mm->aa3 = msg[3];
+   /* ICAO address, recovered from the parity for the Address/Parity
+    * formats */
+   mm->aa1 = frame.icao() >> 16;
+   mm->aa2 = (frame.icao() >> 8) & 0xff;
+   mm->aa3 = frame.icao() & 0xff;
 
    /* DF 17 type (assuming this is a DF17, otherwise not used) */
-   mm->metype = msg[4] >> 3; /* Extended squitter message type. */
-   mm->mesub = msg[4] & 7;   /* Extended squitter message subtype. */
+   mm->metype = frame.metype(); /* Extended squitter message type. */
+   mm->mesub = frame.mesub();   /* Extended squitter message subtype. */
 
    /* Fields for DF4,5,20,21 */
-   mm->fs = msg[0] & 7;           /* Flight status for DF4,5,20,21 */
-   mm->dr = msg[1] >> 3 & 31;     /* Request extraction of downlink request. */
-   mm->um = ((msg[1] & 7) << 3) | /* Request extraction of downlink request. */
-            msg[2] >> 5;
-
-   /* In the squawk (identity) field bits are interleaved like that
-    * (message bit 20 to bit 32):
-    *
-    * C1-A1-C2-A2-C4-A4-ZERO-B1-D1-B2-D2-B4-D4
-    *
-    * So every group of three bits A, B, C, D represent an integer
-    * from 0 to 7.
-    *
-    * The actual meaning is just 4 octal numbers, but we convert it
-    * into a base ten number tha happens to represent the four
-    * octal numbers.
-    *
-    * For more info: http://en.wikipedia.org/wiki/Gillham_code */
-   {
-      int a, b, c, d;
-
-      a = ((msg[3] & 0x80) >> 5) |
-          ((msg[2] & 0x02) >> 0) |
-          ((msg[2] & 0x08) >> 3);
-      b = ((msg[3] & 0x02) << 1) |
-          ((msg[3] & 0x08) >> 2) |
-          ((msg[3] & 0x20) >> 5);
-      c = ((msg[2] & 0x01) << 2) |
-          ((msg[2] & 0x04) >> 1) |
-          ((msg[2] & 0x10) >> 4);
-      d = ((msg[3] & 0x01) << 2) |
-          ((msg[3] & 0x04) >> 1) |
-          ((msg[3] & 0x10) >> 4);
-      mm->identity = a * 1000 + b * 100 + c * 10 + d;
-   }
-
-#if 0
-      /* DF 11 & 17: try to populate our ICAO addresses whitelist.
-       * DFs with an AP field (xored addr and crc), try to decode it. */
-      if (mm->msgtype != 11 && mm->msgtype != 17)
-      {
-         /* Check if we can check the checksum for the Downlink Formats where
-          * the checksum is xored with the aircraft ICAO address. We try to
-          * brute force it using a list of recently seen aircraft addresses. */
-         if (bruteForceAP(msg, mm))
-         {
-            /* We recovered the message, mark the checksum as valid. */
-            mm->crcok = 1;
-         }
-         else
-         {
-            mm->crcok = 0;
-         }
-      }
-      else
-      {
-         /* If this is DF 11 or DF 17 and the checksum was ok,
-          * we can add this address to the list of recently seen
-          * addresses. */
-         if (mm->crcok && mm->errorbit == -1)
-         {
-            uint32_t addr = (mm->aa1 << 16) | (mm->aa2 << 8) | mm->aa3;
-            addRecentlySeenICAOAddr(addr);
-         }
-      }
-#endif
+   mm->fs = frame.fs();
+   mm->dr = frame.dr();
+   mm->um = frame.um();
+   mm->identity = frame.squawk();
 
    /* Decode 13 bit altitude for DF0, DF4, DF16, DF20 */
    if (mm->msgtype == 0 || mm->msgtype == 4 ||
        mm->msgtype == 16 || mm->msgtype == 20)
    {
-      mm->altitude = decodeAC13Field(msg, &mm->unit);
+      mm->altitude = frame.altitude(&mm->unit);
    }
 
    /* Decode extended squitter specific stuff. */
@@ -815,28 +881,16 @@ void Adsb::decodeModesMessage(struct modesMessage *mm, unsigned char *msg)
       {
          /* Aircraft Identification and Category */
          mm->aircraft_type = mm->metype - 1;
-         mm->flight[0] = ais_charset[msg[5] >> 2];
-         mm->flight[1] = ais_charset[((msg[5] & 3) << 4) | (msg[6] >> 4)];
-         mm->flight[2] = ais_charset[((msg[6] & 15) << 2) | (msg[7] >> 6)];
-         mm->flight[3] = ais_charset[msg[7] & 63];
-         mm->flight[4] = ais_charset[msg[8] >> 2];
-         mm->flight[5] = ais_charset[((msg[8] & 3) << 4) | (msg[9] >> 4)];
-         mm->flight[6] = ais_charset[((msg[9] & 15) << 2) | (msg[10] >> 6)];
-         mm->flight[7] = ais_charset[msg[10] & 63];
-         mm->flight[8] = '\0';
+         frame.callsign(mm->flight);
       }
       else if (mm->metype >= 9 && mm->metype <= 18)
       {
          /* Airborne position Message */
-         mm->fflag = msg[6] & (1 << 2);
-         mm->tflag = msg[6] & (1 << 3);
-         mm->altitude = decodeAC12Field(msg, &mm->unit);
-         mm->raw_latitude = ((msg[6] & 3) << 15) |
-                            (msg[7] << 7) |
-                            (msg[8] >> 1);
-         mm->raw_longitude = ((msg[8] & 1) << 16) |
-                             (msg[9] << 8) |
-                             msg[10];
+         mm->fflag = frame.cprOdd();
+         mm->tflag = frame.utcSync();
+         mm->altitude = frame.altitude(&mm->unit);
+         mm->raw_latitude = frame.rawLatitude();
+         mm->raw_longitude = frame.rawLongitude();
       }
       else if (mm->metype == 19 && mm->mesub >= 1 && mm->mesub <= 4)
       {
@@ -850,38 +904,13 @@ void Adsb::decodeModesMessage(struct modesMessage *mm, unsigned char *msg)
             mm->vert_rate_source = (msg[8] & 0x10) >> 4;
             mm->vert_rate_sign = (msg[8] & 0x8) >> 3;
             mm->vert_rate = ((msg[8] & 7) << 6) | ((msg[9] & 0xfc) >> 2);
-            /* Compute velocity and angle from the two speed
-             * components. */
-            mm->velocity = sqrt(mm->ns_velocity * mm->ns_velocity +
-                                mm->ew_velocity * mm->ew_velocity);
-            if (mm->velocity)
-            {
-               int ewv = mm->ew_velocity;
-               int nsv = mm->ns_velocity;
-               double heading;
-
-               if (mm->ew_dir)
-                  ewv *= -1;
-               if (mm->ns_dir)
-                  nsv *= -1;
-               heading = atan2(ewv, nsv);
-
-               /* Convert to degrees. */
-               mm->heading = heading * 360 / (M_PI * 2);
-               /* We don't want negative values but a 0-360 scale. */
-               if (mm->heading < 0)
-                  mm->heading += 360;
-            }
-            else
-            {
-               mm->heading = 0;
-            }
+            mm->velocity = frame.velocity();
+            mm->heading = frame.heading();
          }
          else if (mm->mesub == 3 || mm->mesub == 4)
          {
             mm->heading_is_valid = msg[5] & (1 << 2);
-            mm->heading = (360.0 / 128) * (((msg[5] & 3) << 5) |
-                                           (msg[6] >> 3));
+            mm->heading = frame.heading();
          }
       }
    }
@@ -891,55 +920,69 @@ void Adsb::decodeModesMessage(struct modesMessage *mm, unsigned char *msg)
 /******************************************************************************
  * Reference: https://github.com/antirez/dump1090
 ******************************************************************************/
-void Adsb::processModesMessage(struct modesMessage *mm)
+void Adsb::track(const ModesFrame &frame)
 {
-   // return if CRC is not OK
-   if (mm->crcok == false)
-   {
-      return;
-   }
-
-   if (mm->msgtype == 17)
+   if (frame.df() == 17)
    {
-      uint32_t addr = (mm->aa1 << 16) | (mm->aa2 << 8) | mm->aa3;
+      uint32_t addr = frame.icao();
 
       /* Decode the extended squitter message. */
-      if (mm->metype >= 9 && mm->metype <= 18)
+      if (frame.isPosition())
       {
          auto it = _aircrafts.find(addr);
          // if not found, create a new entry
          if (it == _aircrafts.end())
          {
             _aircrafts[addr] = Aircraft();
+            _aircrafts[addr].addr = addr;
          }
 
          auto a = &(_aircrafts[addr]);
 
          a->seen = time(NULL);
 
-         a->altitude = mm->altitude;
+         a->altitude = frame.altitude();
 
-         if (mm->fflag != 0)
+         if (frame.cprOdd())
          {
-            a->odd_cprlat = mm->raw_latitude;
-            a->odd_cprlon = mm->raw_longitude;
+            a->odd_cprlat = frame.rawLatitude();
+            a->odd_cprlon = frame.rawLongitude();
             a->odd_cprtime = mstime();
          }
          else
          {
-            a->even_cprlat = mm->raw_latitude;
-            a->even_cprlon = mm->raw_longitude;
+            a->even_cprlat = frame.rawLatitude();
+            a->even_cprlon = frame.rawLongitude();
             a->even_cprtime = mstime();
          }
 
          /* If the two data is less than 10 seconds apart, compute
           * the position. */
-         if (llabs(a->even_cprtime - a->odd_cprtime) <= 10000)
+         if (llabs(a->even_cprtime - a->odd_cprtime) <= 10000 && decodeCPR(a))
          {
-            decodeCPR(a);
+            _positionsDecoded++;
          }
       }
    }
+   else if (frame.df() != 11)
+   {
+      /* Address/Parity replies: altitude or squawk for an aircraft already
+       * on the map */
+      auto it = _aircrafts.find(frame.icao());
+      if (it == _aircrafts.end())
+      {
+         return;
+      }
+      it->second.seen = time(NULL);
+      if (frame.df() == 5 || frame.df() == 21)
+      {
+         it->second.squawk = frame.squawk();
+      }
+      else if (frame.altitude() != 0)
+      {
+         it->second.altitude = frame.altitude();
+      }
+   }
 }
 
 /******************************************************************************
@@ -965,7 +1008,9 @@ void Adsb::displayModesMessage(struct modesMessage *mm)
       return;
    }
 
-   if (mm->errorbit != -1)
+   if (mm->errorbit2 != -1)
+      printf("Two bit errors fixed, bits %d and %d\n", mm->errorbit, mm->errorbit2);
+   else if (mm->errorbit != -1)
       printf("Single bit error fixed, bit %d\n", mm->errorbit);
 
    if (mm->msgtype == 0)
@@ -1084,13 +1129,112 @@ void Adsb::displayModesMessage(struct modesMessage *mm)
 /* Detect a Mode S messages inside the magnitude buffer pointed by 'm' and of
  * size 'mlen' bytes. Every detected Mode S message is convert it into a
  * stream of bits and passed to the function to display it. */
-void Adsb::detectModeS(uint32_t mlen)
+void Adsb::detectModeS(uint32_t mlen, uint32_t from, uint32_t seam)
 {
-   uint16_t *m = _magnitudeVector;
+   /* no preamble at or after 'last' has a whole frame behind it yet */
+   const uint32_t last = mlen > MODES_FULL_LEN * 2 ? mlen - MODES_FULL_LEN * 2 : 0;
+   const size_t segments = _segmentFrames.size();
+   const uint32_t span = last > from ? last - from : 0;
+   const uint32_t step = (span + segments - 1) / segments;
+
+   if (segments == 1 || span == 0)
+   {
+      for (auto &frames : _segmentFrames)
+      {
+         frames.clear();
+      }
+      _detectSegment(from, std::max(from, last), _segmentFrames[0]);
+   }
+   else
+   {
+      /* Segment k owns the preambles from k * step; it carries on for a
+       * whole frame past the next cut, so what straddles the cut is found
+       * the way a single scan would find it. */
+      _workers->run([&](size_t k) {
+         const uint32_t start = std::min<uint32_t>(from + k * step, last);
+         const uint32_t to = std::min<uint32_t>(start + step + MODES_FULL_LEN * 2, last);
+         _segmentFrames[k].clear();
+         _detectSegment(start, to, _segmentFrames[k]);
+      });
+   }
+
+   /* Merge in sample order. Preambles up to where the previous segment
+    * stopped were its to find, so a later segment's frames there are
+    * duplicates, or were found before it fell into step; the same goes for
+    * anything starting inside the last frame kept. */
+   uint32_t covered = 0; /* scanned by the segments merged so far */
+   uint32_t next = from; /* first sample after the last frame kept */
+   for (size_t k = 0; k < segments; k++)
+   {
+      for (auto &f : _segmentFrames[k])
+      {
+         if (f.start < covered || f.start < next)
+         {
+            _overlapDuplicates++;
+            continue;
+         }
+         if (f.start < seam)
+         {
+            _seamFrames++;
+         }
+         _emitFrame(f.frame);
+         next = f.end + 1;
+      }
+      covered = std::min<uint32_t>(from + (k + 1) * step + MODES_FULL_LEN * 2, last);
+   }
+
+   /* Move what could not be scanned to the front for the next block, and
+    * note where in it to resume, past any frame that ran into it. */
+   const uint32_t keep = std::min(std::max(from, last), mlen);
+   _carried = mlen - keep;
+   _carryResume = next > keep ? next - keep : 0;
+   memmove(_magnitudeVector, _magnitudeVector + keep, _carried * sizeof(_magnitudeVector[0]));
+}
+
+void Adsb::_emitFrame(const ModesFrame &frame)
+{
+   _framesDecoded++;
+   if (frame.errorbit2() != -1)
+   {
+      _twoBitFixes++;
+   }
+   else if (frame.errorbit() != -1)
+   {
+      _oneBitFixes++;
+   }
+   if (frame.df() == 17)
+   {
+      _df17Frames.fetch_add(1, std::memory_order_relaxed);
+   }
+   if (frame.df() == 11 || frame.df() == 17)
+   {
+      /* only frames that needed no repair vouch for an address */
+      if (frame.errorbit() == -1)
+      {
+         _icaoCache.add(frame.icao(), _streamSeconds);
+      }
+   }
+   else
+   {
+      _apFrames++;
+   }
+   if (_frameSink)
+   {
+      _frameSink(frame);
+   }
+   else
+   {
+      track(frame);
+   }
+}
+
+void Adsb::_detectSegment(uint32_t from, uint32_t to, std::vector<DetectedFrame> &frames)
+{
+   const uint16_t *m = _magnitudeVector;
 
-   unsigned char bits[MODES_LONG_MSG_BITS];
    unsigned char msg[MODES_LONG_MSG_BITS / 2];
-   uint16_t aux[MODES_LONG_MSG_BITS * 2];
+   uint16_t aux[MODES_FULL_LEN * 2];
+   SlicedFrame sliced{};
    uint32_t j;
    int use_correction = 0;
 
@@ -1120,31 +1264,28 @@ void Adsb::detectModeS(uint32_t mlen)
     * 8   --
     * 9   -------------------
     */
-   for (j = 0; j < mlen - MODES_FULL_LEN * 2; j++)
+   for (j = from; j < to; j++)
    {
-      int low, high, delta, i, errors;
+      int high, delta, errors;
+      const uint16_t *p; /* what the bits are sliced from */
       int good_message = 0;
 
       if (use_correction)
+      {
+         p = m + j;
          goto good_preamble; /* We already checked it. */
+      }
 
       /* First check of relations between the first 10 samples
        * representing a valid preamble. We don't even investigate further
-       * if this simple test is not passed. */
-      if (!(m[j] > m[j + 1] &&
-            m[j + 1] < m[j + 2] &&
-            m[j + 2] > m[j + 3] &&
-            m[j + 3] < m[j] &&
-            m[j + 4] < m[j] &&
-            m[j + 5] < m[j] &&
-            m[j + 6] < m[j] &&
-            m[j + 7] > m[j + 8] &&
-            m[j + 8] < m[j + 9] &&
-            m[j + 9] > m[j + 6]))
+       * if this simple test is not passed, so skip straight to the next
+       * offset that passes it (see modesdsp.cpp). */
+      j = _preamble->fn(m, j, to);
+      if (j >= to)
       {
-         // perror("Unexpected ratio among first 10 samples");
-         continue;
+         break;
       }
+      p = m + j;
 
       /* The samples between the two spikes must be < than the average
        * of the high spikes level. We don't test bits too near to
@@ -1172,82 +1313,43 @@ void Adsb::detectModeS(uint32_t mlen)
 
    good_preamble:
       /* If the previous attempt with this message failed, retry using
-       * magnitude correction. */
+       * magnitude correction. It is applied to a copy, as the samples after
+       * the cut are read by the next segment at the same time. */
       if (use_correction)
       {
-         memcpy(aux, m + j + MODES_PREAMBLE_US * 2, sizeof(aux));
+         memcpy(aux, m + j, sizeof(aux));
          if (j && detectOutOfPhase(m + j))
          {
-            applyPhaseCorrection(m + j);
+            applyPhaseCorrection(aux);
          }
+         p = aux;
          /* TODO ... apply other kind of corrections. */
       }
 
-      /* Decode all the next 112 bits, regardless of the actual message
-       * size. We'll check the actual message type later. */
-      errors = 0;
-      for (i = 0; i < MODES_LONG_MSG_BITS * 2; i += 2)
+      /* Decide all the next 112 bits, regardless of the actual message
+       * size, and pack them into bytes. We'll check the actual message type
+       * later. See modesdsp.cpp for the slicers. */
       {
-         low = m[j + i + MODES_PREAMBLE_US * 2];
-         high = m[j + i + MODES_PREAMBLE_US * 2 + 1];
-         delta = low - high;
-         if (delta < 0)
-            delta = -delta;
-
-         if (i > 0 && delta < 256)
-         {
-            bits[i / 2] = bits[i / 2 - 1];
-         }
-         else if (low == high)
-         {
-            /* Checking if two adiacent samples have the same magnitude
-             * is an effective way to detect if it's just random noise
-             * that was detected as a valid preamble. */
-            bits[i / 2] = 2; /* error */
-            if (i < MODES_SHORT_MSG_BITS * 2)
-               errors++;
-         }
-         else if (low > high)
-         {
-            bits[i / 2] = 1;
-         }
-         else
+         uint32_t shortDelta = sliced.shortDelta;
+         uint32_t longDelta = sliced.longDelta;
+         _slice->fn(p + MODES_PREAMBLE_US * 2, sliced);
+         if (use_correction)
          {
-            /* (low < high) for exclusion  */
-            bits[i / 2] = 0;
+            /* the noise check below is on the uncorrected samples, which
+             * the first attempt at this offset already summed */
+            sliced.shortDelta = shortDelta;
+            sliced.longDelta = longDelta;
          }
       }
-
-      /* Restore the original message if we used magnitude correction. */
-      if (use_correction)
-         memcpy(m + j + MODES_PREAMBLE_US * 2, aux, sizeof(aux));
-
-      /* Pack bits into bytes */
-      for (i = 0; i < MODES_LONG_MSG_BITS; i += 8)
-      {
-         msg[i / 8] =
-             bits[i] << 7 |
-             bits[i + 1] << 6 |
-             bits[i + 2] << 5 |
-             bits[i + 3] << 4 |
-             bits[i + 4] << 3 |
-             bits[i + 5] << 2 |
-             bits[i + 6] << 1 |
-             bits[i + 7];
-      }
+      errors = sliced.errors;
+      memcpy(msg, sliced.msg, MODES_LONG_MSG_BYTES);
 
       int msgtype = msg[0] >> 3;
       int msglen = modesMessageLenByType(msgtype) / 8;
 
       /* Last check, high and low bits are different enough in magnitude
        * to mark this as real message and not just noise? */
-      delta = 0;
-      for (i = 0; i < msglen * 8 * 2; i += 2)
-      {
-         delta += abs(m[j + i + MODES_PREAMBLE_US * 2] -
-                      m[j + i + MODES_PREAMBLE_US * 2 + 1]);
-      }
-      delta /= msglen * 4;
+      delta = (msglen == MODES_LONG_MSG_BYTES ? sliced.longDelta : sliced.shortDelta) / (msglen * 4);
 
       /* Filter for an average delta of three is small enough to let almost
        * every kind of message to pass, but high enough to filter some
@@ -1265,15 +1367,24 @@ void Adsb::detectModeS(uint32_t mlen)
       {
          // printf("Recevied message successfully\n");
 
-         struct modesMessage mm;
+         ModesFrame frame;
 
-         /* Decode the received message and update statistics */
-         decodeModesMessage(&mm, msg);
+         /* Check the received message; its fields are decoded by whoever
+          * reads them (decodeModesMessage() fills them all, for display) */
+         bool crcok = checkModesFrame(msg, frame);
 
          /* Pass data to the next layer */
          // useModesMessage(&mm);
          // displayModesMessage(&mm);
-         processModesMessage(&mm);
+         /* Skip this message if we are sure it's fine, so that it is not
+          * decoded a second time by the phase corrected retry below. */
+         if (crcok)
+         {
+            uint32_t end = j + (MODES_PREAMBLE_US + (msglen * 8)) * 2;
+            frames.push_back({j, end, frame});
+            j = end;
+            good_message = 1;
+         }
       }
       else
       {
@@ -1309,3 +1420,9 @@ void Acars::processData(uint8_t *buffer, uint32_t length)
    //logInit();
    runRtlSample_serial(buffer, length);
 }
+
+void Acars::printStats()
+{
+   std::cout << "\n***Printing stats for ACARS decoder***" << std::endl;
+   std::cout << "Messages decoded: " << acarsMessages() << std::endl;
+}
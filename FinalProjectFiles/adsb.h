@@ -6,6 +6,7 @@
  * class Acars - https://github.com/TLeconte/acarsdec
  * 
  * class CircularBuffer - was implemented for processAdsb and processAcars
+ *   (see circularbuffer.h)
  * Edited by - Venetia Furtado
  * Final Project:  Aircraft Detection using Automatic Dependent 
  * Surveillance–Broadcast (ADSB) Data
@@ -33,14 +34,18 @@
 #include <stdexcept>
 #include <atomic>
 #include <stdexcept>
-
-#define CIRCULAR_BUFFER_SIZE 100
-#define BLOCK_SIZE RTLOUTBUFSZ * 160 * 2
-
-extern "C"
-{
-#include "rtl.h"
-}
+#include <thread>
+#include <chrono>
+#include <functional>
+#include <memory>
+
+#include "circularbuffer.h"
+#include "samplesource.h"
+#include "workerpool.h"
+#include "icaocache.h"
+#include "modescrc.h"
+#include "modesframe.h"
+#include "modesdsp.h"
 
 #define MODES_AUTO_GAIN -100 /* Use automatic gain. */
 #define MODES_DEFAULT_RATE 2000000
@@ -57,9 +62,6 @@ extern "C"
 #define MODES_PREAMBLE_US 8   //microseconds
 #define MODES_FULL_LEN (MODES_PREAMBLE_US + MODES_LONG_MSG_BITS)
 
-#define MODES_UNIT_FEET 0
-#define MODES_UNIT_METERS 1
-
 #define INTRATE 12500
 
 //Set map bounds
@@ -79,6 +81,7 @@ typedef struct
    char hexaddr[7]; /* Printable ICAO address */
    char flight[9];  /* Flight number */
    int altitude;    /* Altitude */
+   int squawk;      /* Mode A code, from DF5/DF21; 0 until one is heard */
    int speed;       /* Velocity computed from EW and NS components. */
    int track;       /* Angle of flight. */
    time_t seen;     /* Time at which the last packet was received. */
@@ -99,16 +102,44 @@ typedef struct
 /******************************************************************************
  * Reference: https://github.com/librtlsdr/librtlsdr
 ******************************************************************************/
-class RtlSdr
+#define RTL_ASYNC_BUF_NUM 8 /* USB transfers kept in flight while streaming */
+#define RTL_DRIFT_PPM 500   /* how far the dongle's crystal may run off the wall clock */
+#define RTL_READ_SLACK_US 200 /* pause between sync reads still taken as back to back */
+
+class RtlSdr : public SampleSource
 {
 public:
    RtlSdr();
-   int readSdr(const uint32_t frequency, uint8_t *buffer, uint32_t length);
+   ~RtlSdr();
+   int read(const uint32_t frequency, uint8_t *buffer, uint32_t length) override;
    void closeSdr();
+   const char *name() override { return "rtlsdr"; }
+   uint64_t samplesSkipped() override { return _skipped; }
+
+   /* Continuous capture: park the tuner on 'frequency' and let
+    * rtlsdr_read_async hand every USB transfer to the ring. Each transfer is
+    * exactly one ring block, so there is no retune and no gap between
+    * blocks unless the ring overflows or the USB side drops data. */
+   bool startStreaming(const uint32_t frequency, CircularBuffer *ring) override;
+   void stopStreaming() override;
+   void printStats() override;
 
 private:
+   static void _asyncCallback(unsigned char *buffer, uint32_t length, void *ctx);
+   void _onTransfer(unsigned char *buffer, uint32_t length);
+
    rtlsdr_dev_t *dev = nullptr;
    std::mutex rtlSdr_Mutex;
+   uint32_t _tunedFrequency = ADSB_FREQUENCY;
+   std::chrono::steady_clock::time_point _readEnd; /* when the last read() returned */
+   uint64_t _skipped = 0;
+
+   CircularBuffer *_streamRing = nullptr;
+   std::chrono::steady_clock::time_point _streamStart;
+   std::atomic<uint64_t> _samplesMissed{0}; /* never delivered by USB */
+   std::chrono::steady_clock::time_point _gapLogged;
+   uint64_t _gapsUnlogged = 0;
+   uint64_t _missedUnlogged = 0;
 };
 
 /* The struct we use to store information about a decoded message. */
@@ -124,6 +155,7 @@ struct modesMessage
    int crcok;                               /* True if CRC was valid */
    uint32_t crc;                            /* Message CRC */
    int errorbit;                            /* Bit corrected. -1 if no bit corrected. */
+   int errorbit2;                           /* Second bit corrected, -1 if none. */
    int aa1, aa2, aa3;                       /* ICAO Address bytes 1 2 and 3 */
    int phase_corrected;                     /* True if phase correction was applied. */
 
@@ -168,7 +200,7 @@ class Plotter
 {
 public:
    Plotter();
-   void plotAircrafts(const std::unordered_map<uint32_t, Aircraft> &aircrafts);
+   void plotAircrafts(const std::vector<Aircraft> &aircrafts);
    void close();
 private:
    sf::Vector2f _latlonToPixel(float lat, float lon, int mapWidth, int mapHeight) //converts lat/lon position to pixels on the map
@@ -192,16 +224,61 @@ public:
  * Reference: https://github.com/antirez/dump1090
 ******************************************************************************/
    Adsb();
-   void processData(uint8_t *buffer, uint32_t length);
+
+   /* Demodulate one block. 'sampleIndex' is its stream position
+    * (RTLBuffer::sampleIndex): a block that starts where the previous one
+    * ended is scanned as a continuation of it, so frames across the seam
+    * are decoded whole. Anything else starts a fresh scan. Producers move
+    * the position over samples lost, left unread or jumped, so only blocks
+    * that really follow on from each other are joined. */
+   void processData(uint8_t *buffer, uint32_t length, uint64_t sampleIndex);
+
+   /* Where detectModeS() hands every frame with a good CRC. Without a sink
+    * frames go straight to track() on the decoding thread; with one, the
+    * tracking stage can run elsewhere and call track() itself. */
+   void setFrameSink(std::function<void(const ModesFrame &)> sink) { _frameSink = std::move(sink); }
+
+   /* Demodulate each block in 'segments' pieces at once, one on the calling
+    * thread and the rest on worker threads that run 'setup' when they start.
+    * Each piece is scanned MODES_FULL_LEN * 2 samples into the next, so a
+    * frame across a cut is still found; frames then go to the sink in
+    * sample order, once. 1 (the default) scans the block on the caller. */
+   void setDemodSegments(size_t segments, std::function<void(size_t worker)> setup = nullptr);
+
+   /* Fused mode: compute magnitudes 'samples' at a time and run detection
+    * on each tile while it is still in L1, instead of converting the whole
+    * block first and reading it back. Tiles are joined like contiguous
+    * blocks. 0 (the default) converts whole blocks; ignored with segments. */
+   void setTileSamples(uint32_t samples) { _tileSamples = samples; }
+
+   /* Repair DF11 and DF17 frames whose CRC fails by up to 'bits' flipped
+    * bits: 1 (the default) fixes single bit errors, 2 also fixes two bit
+    * errors in DF17, which lets more noise through; 0 turns it off. */
+   void setErrorCorrection(int bits) { _fixBits = bits; }
+
+   /* Tracking stage: folds one decoded frame into the aircraft table. */
+   void track(const ModesFrame &frame);
+
+   /* Copy of the aircraft table, for a consumer on another thread. Call it
+    * from the thread that runs track(). */
+   std::vector<Aircraft> snapshot();
+
    void removeAircrafts();
    const std::unordered_map<uint32_t, Aircraft>& getAircrafts();
    void printAircrafts();
+   void printStats();
+   uint64_t df17Frames() { return _df17Frames.load(std::memory_order_relaxed); }
+   uint64_t apFrames() { return _apFrames; }
+
+   /* Given the Downlink Format (DF) of the message, return the message length
+    * in bits. */
+   static int modesMessageLenByType(int type);
 private:
 /******************************************************************************
  * Reference: https://github.com/antirez/dump1090
 ******************************************************************************/
    /* Turn I/Q samples pointed in the buffer into the magnitude vector */
-   void _computeMagnitudeVector(uint8_t *buffer, uint32_t length);
+   void _computeMagnitudeVector(uint8_t *buffer, uint32_t length, uint16_t *out);
 
    /* Return -1 if the message is out of fase left-side
     * Return  1 if the message is out of fase right-size
@@ -209,7 +286,7 @@ private:
     *
     * Note: this function will access m[-1], so the caller should make sure to
     * call it only if we are not at the start of the current buffer. */
-   int detectOutOfPhase(uint16_t *m);
+   int detectOutOfPhase(const uint16_t *m);
 
    /* This function does not really correct the phase of the message, it just
     * applies a transformation to the first sample representing a given bit:
@@ -241,21 +318,6 @@ private:
     * correct way. */
    void applyPhaseCorrection(uint16_t *m);
 
-   /* Given the Downlink Format (DF) of the message, return the message length
-    * in bits. */
-   int modesMessageLenByType(int type);
-
-   uint32_t modesChecksum(unsigned char *msg, int bits);
-
-   /* Decode the 12 bit AC altitude field (in DF 17 and others).
-    * Returns the altitude or 0 if it can't be decoded. */
-   int decodeAC12Field(unsigned char *msg, int *unit);
-
-   /* Decode the 13 bit AC altitude field (in DF 20 and others).
-    * Returns the altitude, and set 'unit' to either MODES_UNIT_METERS
-    * or MDOES_UNIT_FEETS. */
-   int decodeAC13Field(unsigned char *msg, int *unit);
-
    /* Always positive MOD operation, used for CPR decoding. */
    int cprModFunction(int a, int b);
 
@@ -275,28 +337,81 @@ private:
     * 2) We assume that we always received the odd packet as last packet for
     *    simplicity. This may provide a position that is less fresh of a few
     *    seconds.
+    * Returns false, leaving the position alone, when the two frames are in
+    * different latitude zones.
     */
-   void decodeCPR(Aircraft *a);
+   bool decodeCPR(Aircraft *a);
+
+   /* Check the parity of a frame demodulated by detectModeS(), repairing
+    * bit errors and recovering the address of Address/Parity formats where
+    * it can. 'frame' gets the bytes either way; true if they are good. */
+   bool checkModesFrame(const unsigned char *msg, ModesFrame &frame);
 
    /* Decode a raw Mode S message demodulated as a stream of bytes by
     * detectModeS(), and split it into fields populating a modesMessage
-    * structure. */
+    * structure, for display. */
    void decodeModesMessage(struct modesMessage *mm, unsigned char *msg);
 
-   void processModesMessage(struct modesMessage *mm);
-
    /* This function gets a decoded Mode S Message and prints it on the screen
     * in a human readable format. */
    void displayModesMessage(struct modesMessage *mm);
 
-   /* Detect a Mode S messages inside the magnitude buffer pointed by 'm' and of
-    * size 'mlen' bytes. Every detected Mode S message is convert it into a
-    * stream of bits and passed to the function to display it. */
-   void detectModeS(uint32_t mlen);
+   /* Detect a Mode S messages inside the magnitude vector of 'mlen' samples,
+    * trying preambles from 'from' on; the first 'seam' samples are the
+    * previous block's tail. Every detected Mode S message is convert it into
+    * a stream of bits, decoded, and the ones with a good CRC handed to the
+    * frame sink. What is too close to the end to scan is moved to the front
+    * of the vector for the next block. */
+   void detectModeS(uint32_t mlen, uint32_t from, uint32_t seam);
 
-   uint16_t _magnitudeVector[BUFFER_LENGTH];
-   uint16_t _magnitudeLookupTable[129][129];
+   /* A frame found by _detectSegment(), with the samples it covers. */
+   struct DetectedFrame
+   {
+      uint32_t start;
+      uint32_t end;
+      ModesFrame frame;
+   };
+
+   /* Scan for preambles starting in [from, to) and collect the frames with
+    * a good CRC. Only reads the magnitude vector, so segments can run in
+    * parallel. */
+   void _detectSegment(uint32_t from, uint32_t to, std::vector<DetectedFrame> &frames);
+
+   /* Count a good frame and pass it on to the sink, or to track(). */
+   void _emitFrame(const ModesFrame &frame);
+
+   /* Room for the previous block's tail ahead of a full block */
+   uint16_t _magnitudeVector[MODES_FULL_LEN * 2 + BUFFER_LENGTH];
+   uint32_t _carried = 0;         /* tail samples moved to the front */
+   uint32_t _carryResume = 0;     /* where in them scanning picks up */
+   uint64_t _nextSampleIndex = 0; /* stream position just after the last block */
+   const MagnitudeKernel *_magnitude; /* fastest ones this CPU has */
+   const PreambleKernel *_preamble;
+   const SliceKernel *_slice;
+   const CrcKernel *_crc;
+   IcaoCache _icaoCache;        /* filled in _emitFrame(), read while decoding */
+   uint32_t _streamSeconds = 0; /* stream time of the block being decoded */
    std::unordered_map<uint32_t, Aircraft> _aircrafts;
+   std::function<void(const ModesFrame &)> _frameSink;
+
+   std::unique_ptr<WorkerPool> _workers;
+   std::vector<std::vector<DetectedFrame>> _segmentFrames{1};
+   uint64_t _overlapDuplicates = 0; /* found twice where segments overlap */
+   uint64_t _seamFrames = 0;        /* started in the previous block */
+
+   uint32_t _tileSamples = 0;
+   int _missCounter = -2;           /* perf fd for LLC misses, -1: none, -2: not opened */
+   uint64_t _demodBlocks = 0;
+   uint64_t _demodNs = 0;
+   uint64_t _cacheMisses = 0;
+
+   int _fixBits = 1;
+   uint64_t _framesDecoded = 0; /* CRC ok, any DF */
+   uint64_t _oneBitFixes = 0;   /* of which repaired */
+   uint64_t _twoBitFixes = 0;
+   uint64_t _apFrames = 0;      /* DF0/4/5/16/20/21 matched to a known address */
+   std::atomic<uint64_t> _df17Frames{0}; /* read by the band scheduler */
+   uint64_t _positionsDecoded = 0;
 };
 
 class Acars
@@ -308,6 +423,7 @@ public:
    Acars();
    unsigned int getFrequency();
    void processData(uint8_t *buffer, uint32_t length);
+   void printStats();
    void logInit()
    {
       if(isLogInit == false)
@@ -320,81 +436,3 @@ private:
    unsigned int frequency;
    bool isLogInit = false;
 };
-
-typedef struct
-{
-   uint8_t buffer[BLOCK_SIZE];
-   int n_read;
-} RTLBuffer;
-
-class CircularBuffer
-{
-public:
-   CircularBuffer()
-       : _head(0), _tail(0), _size(0), _capacity(CIRCULAR_BUFFER_SIZE) {}
-
-   RTLBuffer *getPtrToHead()
-   {
-      if (is_full())
-      {
-         //perror("Buffer is full");
-         return nullptr;
-      }
-      RTLBuffer *res = &(_buffer[_head]);
-      return res;
-   }
-
-   void push()
-   {
-      if (is_full())
-      {
-         //perror("Buffer is full");
-         return;
-      }
-      _head = (_head + 1) % _capacity;
-      _size++;
-   }
-
-   RTLBuffer *getPtrToTail()
-   {
-      if (is_empty())
-      {
-         //perror("Buffer is empty");
-         return nullptr;
-      }
-      RTLBuffer *item = &(_buffer[_tail]);
-      return item;
-   }
-
-   // Remove and return the oldest element
-   void pop()
-   {
-      if (is_empty())
-      {
-         //perror("Buffer is empty");
-         return;
-      }
-      _tail = (_tail + 1) % _capacity;
-      _size--;
-      return;
-   }
-
-   // Check if buffer is empty
-   bool is_empty() { return _size == 0; }
-
-   // Check if buffer is full
-   bool is_full() { return _size == _capacity; }
-
-   // Get current number of elements
-   size_t size() { return _size; }
-
-   // Get maximum capacity
-   size_t capacity() { return _capacity; }
-
-private:
-   RTLBuffer _buffer[CIRCULAR_BUFFER_SIZE]; // Storage for elements
-   size_t _head;                            // Index of oldest element
-   size_t _tail;                            // Index where next element will be added
-   std::atomic<size_t> _size;               // Current number of elements
-   size_t _capacity;
-};
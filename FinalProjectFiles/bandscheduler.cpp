@@ -0,0 +1,232 @@
+/*******************************************************************************
+ * class BandScheduler - see bandscheduler.h
+ * Final Project:  Aircraft Detection using Automatic Dependent
+ * Surveillance–Broadcast (ADSB) Data
+ * ECEN 5613 - Spring 2025
+ * University of Colorado Boulder
+*
+********************************************************************************/
+#include "bandscheduler.h"
+#include "adsb.h"
+#include <string_view>
+
+BandScheduler::BandScheduler(SampleSource *source) : _source(source), _settle(BAND_SETTLE_SAMPLES * 2)
+{
+}
+
+void BandScheduler::addBand(const char *name, uint32_t frequency, CircularBuffer *ring,
+                            std::function<uint64_t()> decoded, double weight, uint32_t minDwell)
+{
+   if (_source->covers(frequency) == false)
+   {
+      return;
+   }
+
+   Band b{};
+   b.name = name;
+   b.frequency = frequency;
+   b.ring = ring;
+   b.decoded = decoded;
+   b.weight = weight;
+   b.minDwell = std::max<uint32_t>(minDwell, 1);
+   b.dwell = std::max<uint32_t>(b.minDwell, BAND_CYCLE_BLOCKS / 2);
+   b.cycleStart = decoded();
+   _bands.push_back(b);
+}
+
+void BandScheduler::readNext()
+{
+   if (_bands.empty())
+   {
+      return;
+   }
+
+   if (_left == 0)
+   {
+      size_t next = _tuned ? (_current + 1) % _bands.size() : 0;
+      if (_tuned && next == 0)
+      {
+         _endCycle();
+      }
+
+      auto now = std::chrono::steady_clock::now();
+      if (_tuned)
+      {
+         _bands[_current].tunedNs += std::chrono::duration_cast<std::chrono::nanoseconds>(now - _tunedAt).count();
+      }
+      _tunedAt = now;
+
+      // with a single band the tuner never moves, so there is nothing to settle
+      bool retune = _tuned == false || next != _current;
+      _current = next;
+      _left = _bands[_current].dwell;
+      if (retune)
+      {
+         _retune(_current);
+      }
+      _tuned = true;
+   }
+
+   Band &band = _bands[_current];
+   _left--;
+
+   RTLBuffer *b = band.ring->claim();
+   if (b == nullptr)
+   {
+      band.ringFull++;
+      return;
+   }
+
+   auto logTime = [](std::string_view log){auto now = std::chrono::system_clock::now();
+      auto duration = now.time_since_epoch();
+      auto microseconds = std::chrono::duration_cast<std::chrono::microseconds>(duration);
+      syslog(LOG_INFO, "%s: %ld",log.data(), microseconds.count());
+   };
+
+   logTime("Before read:");
+   int readLen = _source->read(band.frequency, b->buffer, b->capacity);
+   logTime("After read:");
+
+   if (readLen < 0)
+   {
+      perror("Unable to read from SDR");
+      return;
+   }
+
+   // a live source kept sampling while the block waited for its turn
+   _skip(_source->samplesSkipped());
+
+   b->n_read = readLen;
+   b->sampleIndex = _position;
+   b->frequency = band.frequency;
+   b->sampleRate = MODES_DEFAULT_RATE;
+   b->timestampNs = captureTimeNs();
+   band.ring->commit();
+   _position += readLen / 2;
+   band.samples += readLen / 2;
+   band.cycleSamples += readLen / 2;
+}
+
+void BandScheduler::readDwell()
+{
+   do
+   {
+      readNext();
+   } while (_left > 0);
+}
+
+uint32_t BandScheduler::maxDwell()
+{
+   const double maxShare = _bands.size() < 2 ? 1.0 : 1 - BAND_MIN_SHARE * (_bands.size() - 1);
+   uint32_t longest = 0;
+   for (const Band &b : _bands)
+   {
+      longest = std::max({longest, b.minDwell, b.dwell, (uint32_t)lround(maxShare * BAND_CYCLE_BLOCKS)});
+   }
+   return longest;
+}
+
+/* The first samples after a retune still carry the old band (and the
+ * PLL lock transient), so read them into a scratch buffer and drop them. */
+void BandScheduler::_retune(size_t band)
+{
+   Band &b = _bands[band];
+   int n = _source->read(b.frequency, _settle.data(), _settle.size());
+   if (n > 0)
+   {
+      _skip(_source->samplesSkipped());
+      _position += n / 2;
+      b.settleSamples += n / 2;
+   }
+}
+
+/* Move the sample clock over samples the source let go by, so the next
+ * block does not look like it carries straight on from the last. */
+void BandScheduler::_skip(uint64_t samples)
+{
+   _position += samples;
+   _skipped += samples;
+}
+
+/* Re-split the next cycle in proportion to weighted decode yield. */
+void BandScheduler::_endCycle()
+{
+   double total = 0;
+   for (Band &b : _bands)
+   {
+      uint64_t decoded = b.decoded();
+      if (b.cycleSamples > 0)
+      {
+         double rate = (decoded - b.cycleStart) / ((double)b.cycleSamples / MODES_DEFAULT_RATE);
+         b.yield = (_cycles == 0) ? rate : BAND_YIELD_ALPHA * rate + (1 - BAND_YIELD_ALPHA) * b.yield;
+      }
+      b.cycleStart = decoded;
+      b.cycleSamples = 0;
+      total += b.weight * b.yield;
+   }
+   _cycles++;
+
+   if (_bands.size() < 2)
+   {
+      return;
+   }
+
+   const double maxShare = 1 - BAND_MIN_SHARE * (_bands.size() - 1);
+   for (Band &b : _bands)
+   {
+      double share = (total > 0) ? b.weight * b.yield / total : 1.0 / _bands.size();
+      share = std::clamp(share, BAND_MIN_SHARE, maxShare);
+      uint32_t dwell = std::max<uint32_t>(b.minDwell, lround(share * BAND_CYCLE_BLOCKS));
+      if (dwell != b.dwell)
+      {
+         syslog(LOG_INFO, "BandScheduler: %s dwell %u -> %u blocks (%.2f decoded/s)",
+                b.name, b.dwell, dwell, b.yield);
+         b.dwell = dwell;
+      }
+   }
+}
+
+double BandScheduler::sampleDuty(size_t band)
+{
+   if (_position == _skipped || band >= _bands.size())
+   {
+      return 0;
+   }
+   return (double)_bands[band].samples / (_position - _skipped);
+}
+
+double BandScheduler::timeDuty(size_t band)
+{
+   if (_tuned == false || band >= _bands.size())
+   {
+      return 0;
+   }
+
+   auto now = std::chrono::steady_clock::now();
+   uint64_t current = std::chrono::duration_cast<std::chrono::nanoseconds>(now - _tunedAt).count();
+   uint64_t total = current;
+   for (const Band &b : _bands)
+   {
+      total += b.tunedNs;
+   }
+   uint64_t mine = _bands[band].tunedNs + (band == _current ? current : 0);
+   return total > 0 ? (double)mine / total : 0;
+}
+
+void BandScheduler::printStats()
+{
+   std::cout << "\n***Printing stats for band scheduler***" << std::endl;
+   std::cout << "Cycles: " << _cycles << std::endl;
+   std::cout << "Samples gone by between reads: " << _skipped << std::endl;
+   for (size_t i = 0; i < _bands.size(); i++)
+   {
+      const Band &b = _bands[i];
+      std::cout << b.name << " (" << b.frequency << " Hz):" << std::endl;
+      std::cout << "  Dwell: " << b.dwell << " blocks" << std::endl;
+      std::cout << "  Yield: " << b.yield << " decoded/s" << std::endl;
+      std::cout << "  Duty cycle: " << 100 * sampleDuty(i) << "% of samples, "
+                << 100 * timeDuty(i) << "% of time tuned" << std::endl;
+      std::cout << "  Settle samples discarded: " << b.settleSamples << std::endl;
+      std::cout << "  Blocks skipped, ring full: " << b.ringFull << std::endl;
+   }
+}
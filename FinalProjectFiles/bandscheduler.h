@@ -0,0 +1,89 @@
+/*******************************************************************************
+ * class BandScheduler - shares the one dongle between the ADS-B and ACARS
+ * bands. Each band gets a dwell of whole blocks per cycle, sized from the
+ * decode yield it had over the recent cycles, and the samples captured
+ * right after a retune are thrown away while the tuner settles.
+ * Final Project:  Aircraft Detection using Automatic Dependent
+ * Surveillance–Broadcast (ADSB) Data
+ * ECEN 5613 - Spring 2025
+ * University of Colorado Boulder
+*
+********************************************************************************/
+#pragma once
+
+#include <stdint.h>
+#include <chrono>
+#include <functional>
+#include <vector>
+
+#include "circularbuffer.h"
+#include "samplesource.h"
+
+#define BAND_CYCLE_BLOCKS 16       /* blocks per scheduling cycle, ~1.3 s of samples */
+#define BAND_SETTLE_SAMPLES 16384  /* discarded after every retune, 8 ms */
+#define BAND_MIN_SHARE 0.15        /* a quiet band is still listened to this much */
+#define BAND_YIELD_ALPHA 0.3       /* weight of the last cycle in the yield average */
+
+class BandScheduler
+{
+public:
+   explicit BandScheduler(SampleSource *source);
+
+   /* 'decoded' returns the band decoder's running count of good messages.
+    * 'weight' is what one of them is worth next to one from another band,
+    * and 'minDwell' the shortest useful visit in blocks (an ACARS block
+    * only decodes if the whole burst lands in one dwell). Bands the
+    * source does not cover are ignored. */
+   void addBand(const char *name, uint32_t frequency, CircularBuffer *ring,
+                std::function<uint64_t()> decoded, double weight, uint32_t minDwell);
+
+   /* Read one block for the band whose turn it is into that band's ring. */
+   void readNext();
+
+   /* Read the rest of the current dwell, or else the whole next one, back
+    * to back, so the blocks of a dwell are contiguous on the air. */
+   void readDwell();
+
+   /* Longest dwell any band can be given, in blocks. */
+   uint32_t maxDwell();
+
+   /* Fraction of captured samples, and of wall time tuned, per band. */
+   double sampleDuty(size_t band);
+   double timeDuty(size_t band);
+   void printStats();
+
+private:
+   struct Band
+   {
+      const char *name;
+      uint32_t frequency;
+      CircularBuffer *ring;
+      std::function<uint64_t()> decoded;
+      double weight;
+      uint32_t minDwell;
+
+      uint32_t dwell;          /* blocks this cycle */
+      uint64_t cycleStart;     /* decoded count when the cycle started */
+      uint64_t cycleSamples;   /* samples captured this cycle */
+      double yield;            /* decoded per second listened, averaged */
+      uint64_t samples;        /* samples delivered to the ring */
+      uint64_t settleSamples;  /* samples thrown away after retuning here */
+      uint64_t ringFull;       /* blocks not read because the ring was full */
+      uint64_t tunedNs;
+   };
+
+   void _retune(size_t band);
+   void _skip(uint64_t samples);
+   void _endCycle();
+
+   SampleSource *_source;
+   std::vector<Band> _bands;
+   size_t _current = 0;
+   uint32_t _left = 0;     /* blocks left in the current dwell */
+   bool _tuned = false;
+   uint64_t _position = 0; /* sample clock, settle and unread samples included */
+   uint64_t _skipped = 0;  /* samples a live source let go by between reads */
+   uint64_t _cycles = 0;
+   std::chrono::steady_clock::time_point _tunedAt;
+   std::vector<uint8_t> _settle;
+};
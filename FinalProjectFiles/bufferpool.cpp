@@ -0,0 +1,209 @@
+/*******************************************************************************
+ * class BufferPool - see bufferpool.h
+ * Final Project:  Aircraft Detection using Automatic Dependent
+ * Surveillance–Broadcast (ADSB) Data
+ * ECEN 5613 - Spring 2025
+ * University of Colorado Boulder
+*
+********************************************************************************/
+#include "bufferpool.h"
+#include "adsb.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <syslog.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#define POOL_PAGE 4096
+#define POOL_HUGE_PAGE (2 * 1024 * 1024)
+
+size_t poolRound(size_t bytes)
+{
+   return (bytes + POOL_PAGE - 1) & ~(size_t)(POOL_PAGE - 1);
+}
+
+bool PoolConfig::parse(char *spec)
+{
+   enum { ADSB, ACARS, SIZE, HUGE, LOCK, POLICY, TIMEOUT };
+   char kAdsb[] = "adsb", kAcars[] = "acars", kSize[] = "size", kHuge[] = "huge", kLock[] = "lock",
+        kPolicy[] = "policy", kTimeout[] = "timeout";
+   char *const keys[] = {kAdsb, kAcars, kSize, kHuge, kLock, kPolicy, kTimeout, nullptr};
+
+   char *value;
+   while (*spec != '\0')
+   {
+      int key = getsubopt(&spec, keys, &value);
+      if (key < 0 || value == nullptr)
+      {
+         return false;
+      }
+      switch (key)
+      {
+      case ADSB:
+         adsbBlocks = strtoul(value, nullptr, 0);
+         break;
+      case ACARS:
+         acarsBlocks = strtoul(value, nullptr, 0);
+         break;
+      case SIZE:
+         adsbBlockSize = strtoul(value, nullptr, 0);
+         break;
+      case HUGE:
+         hugePages = atoi(value) != 0;
+         break;
+      case LOCK:
+         lock = atoi(value) != 0;
+         break;
+      case POLICY:
+         if (strcmp(value, "drop") == 0)
+         {
+            policy = RingPolicy::DropNewest;
+         }
+         else if (strcmp(value, "overwrite") == 0)
+         {
+            policy = RingPolicy::OverwriteOldest;
+         }
+         else if (strcmp(value, "block") == 0)
+         {
+            policy = RingPolicy::Block;
+         }
+         else
+         {
+            return false;
+         }
+         break;
+      case TIMEOUT:
+         timeoutMs = strtoul(value, nullptr, 0);
+         break;
+      }
+   }
+
+   /* librtlsdr wants transfers in multiples of 512 bytes, and a block may
+    * not hold more samples than Adsb's magnitude vector. */
+   return adsbBlocks > 0 && acarsBlocks > 0 && adsbBlockSize > 0 &&
+          adsbBlockSize % 512 == 0 && adsbBlockSize <= BUFFER_LENGTH * 2;
+}
+
+size_t PoolConfig::bytes() const
+{
+   return poolRound((size_t)adsbBlocks * adsbBlockSize) + poolRound((size_t)acarsBlocks * BLOCK_SIZE);
+}
+
+BufferPool::BufferPool(size_t bytes, bool hugePages, bool lock)
+{
+   _size = poolRound(bytes);
+   void *p = MAP_FAILED;
+
+   if (hugePages)
+   {
+      size_t huge = (_size + POOL_HUGE_PAGE - 1) & ~(size_t)(POOL_HUGE_PAGE - 1);
+      p = mmap(nullptr, huge, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+      if (p != MAP_FAILED)
+      {
+         _size = huge;
+         _hugePages = true;
+      }
+      else
+      {
+         syslog(LOG_WARNING, "BufferPool: no hugepages reserved (%s), using normal pages", strerror(errno));
+         std::cerr << "No hugepages reserved (vm.nr_hugepages), using normal pages\n";
+      }
+   }
+
+   if (p == MAP_FAILED)
+   {
+      p = mmap(nullptr, _size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (p == MAP_FAILED)
+      {
+         throw std::runtime_error(std::string("Unable to allocate the buffer pool: ") + strerror(errno));
+      }
+      if (hugePages)
+      {
+         madvise(p, _size, MADV_HUGEPAGE); // transparent hugepages, if enabled
+      }
+   }
+   _base = static_cast<uint8_t *>(p);
+
+   if (lock)
+   {
+      if (mlock(_base, _size) == 0)
+      {
+         _locked = true;
+      }
+      else
+      {
+         syslog(LOG_WARNING, "BufferPool: mlock of %zu bytes failed (%s)", _size, strerror(errno));
+         std::cerr << "Unable to lock the buffer pool in RAM (ulimit -l?): " << strerror(errno) << "\n";
+      }
+   }
+}
+
+BufferPool::~BufferPool()
+{
+   if (_locked)
+   {
+      munlock(_base, _size);
+   }
+   munmap(_base, _size);
+}
+
+uint8_t *BufferPool::take(size_t bytes)
+{
+   bytes = poolRound(bytes);
+   if (bytes > _size - _used)
+   {
+      throw std::runtime_error("Buffer pool exhausted");
+   }
+   uint8_t *p = _base + _used;
+   _used += bytes;
+   return p;
+}
+
+size_t BufferPool::resident()
+{
+   const size_t page = sysconf(_SC_PAGESIZE);
+   std::vector<unsigned char> pages((_size + page - 1) / page);
+   if (mincore(_base, _size, pages.data()) < 0)
+   {
+      return 0;
+   }
+
+   size_t n = 0;
+   for (unsigned char v : pages)
+   {
+      n += v & 1;
+   }
+   return std::min(n * page, _size);
+}
+
+/* VmRSS / VmHWM lines of /proc/self/status, in kB. */
+static long procStatus(const char *key)
+{
+   std::ifstream status("/proc/self/status");
+   std::string line;
+   size_t n = strlen(key);
+   while (std::getline(status, line))
+   {
+      if (line.compare(0, n, key) == 0 && line.size() > n && line[n] == ':')
+      {
+         return atol(line.c_str() + n + 1);
+      }
+   }
+   return -1;
+}
+
+void BufferPool::printStats()
+{
+   std::cout << "\n***Printing stats for buffer pool***" << std::endl;
+   std::cout << "Pool size: " << _size / 1024 << "kB (" << _used / 1024 << "kB carved)"
+             << (_hugePages ? ", hugepages" : "") << (_locked ? ", locked" : "") << std::endl;
+   // ring blocks are reused, never given back, so this is also the pool's peak
+   std::cout << "Pool resident: " << resident() / 1024 << "kB" << std::endl;
+   std::cout << "Process resident: " << procStatus("VmRSS") << "kB, peak " << procStatus("VmHWM") << "kB" << std::endl;
+}
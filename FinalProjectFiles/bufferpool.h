@@ -0,0 +1,61 @@
+/*******************************************************************************
+ * class BufferPool - one up-front allocation that the capture rings carve
+ * their IQ blocks out of. It can be backed by hugepages and locked in RAM,
+ * and reports how much of it (and of the process) is actually resident.
+ * Final Project:  Aircraft Detection using Automatic Dependent
+ * Surveillance–Broadcast (ADSB) Data
+ * ECEN 5613 - Spring 2025
+ * University of Colorado Boulder
+*
+********************************************************************************/
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "circularbuffer.h"
+
+/* Sizes and overflow policy of the two capture rings, as given to -m. The
+ * ACARS block size is fixed: runRtlSample_serial() only takes whole
+ * BLOCK_SIZE reads. */
+struct PoolConfig
+{
+   uint32_t adsbBlocks = CIRCULAR_BUFFER_SIZE;
+   uint32_t acarsBlocks = CIRCULAR_BUFFER_SIZE;
+   uint32_t adsbBlockSize = BLOCK_SIZE;
+   bool hugePages = false;
+   bool lock = false;
+   RingPolicy policy = RingPolicy::DropNewest;
+   uint32_t timeoutMs = 50;  /* RingPolicy::Block */
+
+   /* Parse "key=value,...". Returns false on a bad key or size. */
+   bool parse(char *spec);
+   size_t bytes() const;
+};
+
+class BufferPool
+{
+public:
+   BufferPool(size_t bytes, bool hugePages, bool lock);
+   ~BufferPool();
+
+   /* Carve 'bytes' out of the pool, page aligned. Throws once exhausted. */
+   uint8_t *take(size_t bytes);
+
+   size_t size() { return _size; }
+   size_t used() { return _used; }
+
+   /* Bytes of the pool currently backed by RAM (mincore). */
+   size_t resident();
+   void printStats();
+
+private:
+   uint8_t *_base = nullptr;
+   size_t _size = 0;
+   size_t _used = 0;
+   bool _hugePages = false;
+   bool _locked = false;
+};
+
+/* Page rounding used by BufferPool::take(), for sizing a pool. */
+size_t poolRound(size_t bytes);
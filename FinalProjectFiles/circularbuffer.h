@@ -0,0 +1,286 @@
+/*******************************************************************************
+ * class CircularBuffer - was implemented for processAdsb and processAcars
+ * Edited by - Venetia Furtado
+ * Final Project:  Aircraft Detection using Automatic Dependent 
+ * Surveillance–Broadcast (ADSB) Data
+ * ECEN 5613 - Spring 2025
+ * University of Colorado Boulder
+ * Revised 04/29/2025
+*
+********************************************************************************/
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <time.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+extern "C"
+{
+#include "rtl.h"
+}
+
+#define CIRCULAR_BUFFER_SIZE 100 /* default blocks per ring */
+#define BLOCK_SIZE RTLOUTBUFSZ * 160 * 2
+#define CACHE_LINE 64 /* keeps the producer and consumer indices apart */
+
+typedef struct
+{
+   uint8_t *buffer;      /* 'capacity' bytes in the BufferPool */
+   uint32_t capacity;
+   int n_read;
+   uint64_t sampleIndex; /* Stream position of buffer[0], in IQ samples. */
+   uint32_t frequency;   /* Tuner centre frequency, Hz. */
+   uint32_t sampleRate;  /* IQ samples per second. */
+   uint64_t timestampNs; /* CLOCK_REALTIME when the block was captured. */
+} RTLBuffer;
+
+/* Wall-clock capture time for RTLBuffer::timestampNs */
+static inline uint64_t captureTimeNs()
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_REALTIME, &ts);
+   return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/* What the producer does when the ring is full. */
+enum class RingPolicy
+{
+   DropNewest,      /* lose the block being captured */
+   OverwriteOldest, /* lose the oldest block the decoder has not started,
+                     * unless it is decoding the oldest block: that one
+                     * holds the slot the new block needs, so the new block
+                     * is dropped (counted as dropped, not overwritten) */
+   Block,           /* wait for the decoder, up to a timeout, then drop */
+};
+
+/* Counters for one ring; see CircularBuffer::stats(). */
+struct RingStats
+{
+   uint64_t produced;  /* blocks committed */
+   uint64_t consumed;  /* blocks handed back by the decoder */
+   uint64_t dropped;     /* new blocks lost to a full ring */
+   uint64_t overwritten; /* unread blocks retired for new ones */
+   size_t depth;       /* blocks committed and not yet consumed */
+   size_t highWater;   /* deepest the ring has been */
+};
+
+/* Single-producer / single-consumer ring of capture blocks.
+ *
+ * The producer claim()s the block at the head, fills it and commit()s it;
+ * the consumer peek()s the oldest unread block, decodes it and consume()s
+ * it. A block only becomes visible to the consumer with the release store
+ * of _head in commit(), so it is never seen half written.
+ * _head and _tail count blocks from 0 and never wrap back, the slot is the
+ * count modulo the capacity. _tail is the oldest block nobody has taken:
+ * peek() takes it with a CAS and parks its index in _hold until consume(),
+ * which lets the producer retire unread blocks under OverwriteOldest while
+ * never touching the one being decoded. The producer keeps a cached copy of
+ * the oldest block in use and the consumer one of _head, and only reload
+ * them when the ring looks full / empty. */
+class CircularBuffer
+{
+public:
+   /* 'storage' holds 'blocks' blocks of 'blockSize' bytes, see BufferPool */
+   CircularBuffer(uint8_t *storage, size_t blocks, uint32_t blockSize)
+       : _buffer(new RTLBuffer[blocks]()), _capacity(blocks), _blockSize(blockSize)
+   {
+      for (size_t i = 0; i < blocks; i++)
+      {
+         _buffer[i].buffer = storage + i * blockSize;
+         _buffer[i].capacity = blockSize;
+      }
+   }
+
+   /* Set before the producer starts. 'timeoutMs' only applies to Block. */
+   void setPolicy(RingPolicy policy, uint32_t timeoutMs)
+   {
+      _policy = policy;
+      _timeout = std::chrono::milliseconds(timeoutMs);
+   }
+
+   /* Producer: the next free block, applying the overflow policy when the
+    * ring is full. Returns nullptr, and counts a drop, when that fails.
+    * Claiming again without a commit() returns the same block. */
+   RTLBuffer *claim()
+   {
+      RTLBuffer *b = tryClaim();
+      if (b != nullptr)
+      {
+         return b;
+      }
+
+      if (_policy == RingPolicy::OverwriteOldest)
+      {
+         // only an unread block can go; the one being decoded stays, and
+         // if it is the oldest, its slot is the one we need, so retiring the
+         // next one frees nothing and the new block is dropped below
+         size_t tail = _tail.load();
+         if (_hold.load() >= tail && _tail.compare_exchange_strong(tail, tail + 1))
+         {
+            _overwritten.fetch_add(1, std::memory_order_relaxed);
+            b = tryClaim();
+         }
+      }
+      else if (_policy == RingPolicy::Block)
+      {
+         auto deadline = std::chrono::steady_clock::now() + _timeout;
+         while ((b = tryClaim()) == nullptr && std::chrono::steady_clock::now() < deadline)
+         {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+         }
+      }
+
+      if (b == nullptr)
+      {
+         _dropped.fetch_add(1, std::memory_order_relaxed);
+      }
+      return b;
+   }
+
+   /* Producer: the next free block, or nullptr when the ring is full. No
+    * policy, no counting; for producers that do their own waiting. */
+   RTLBuffer *tryClaim()
+   {
+      const size_t head = _head.load(std::memory_order_relaxed);
+      if (head - _oldestCache == _capacity)
+      {
+         _oldestCache = _oldest();
+         if (head - _oldestCache == _capacity)
+         {
+            return nullptr;
+         }
+      }
+      return &_buffer[head % _capacity];
+   }
+
+   /* Producer: publish the block returned by claim(). */
+   void commit()
+   {
+      const size_t head = _head.load(std::memory_order_relaxed) + 1;
+      _head.store(head, std::memory_order_release);
+      _produced.store(_produced.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+      size_t depth = head - _oldest();
+      if (depth > _highWater.load(std::memory_order_relaxed))
+      {
+         _highWater.store(depth, std::memory_order_relaxed);
+      }
+   }
+
+   /* Consumer: the oldest committed block, or nullptr when the ring is empty.
+    * Peeking again without a consume() returns the same block. */
+   RTLBuffer *peek()
+   {
+      if (_holding)
+      {
+         return &_buffer[_held % _capacity];
+      }
+
+      size_t tail = _tail.load();
+      while (true)
+      {
+         // <= since the producer may have moved _tail past our cached _head
+         if (_headCache <= tail)
+         {
+            _headCache = _head.load(std::memory_order_acquire);
+            if (_headCache == tail)
+            {
+               _hold.store(NO_HOLD);
+               return nullptr;
+            }
+         }
+         // announce the block before taking it, see claim()
+         _hold.store(tail);
+         if (_tail.compare_exchange_strong(tail, tail + 1))
+         {
+            break;
+         }
+         // the producer overwrote it; 'tail' now holds the new oldest block
+      }
+
+      _held = tail;
+      _holding = true;
+      return &_buffer[tail % _capacity];
+   }
+
+   /* Consumer: hand the block returned by peek() back to the producer. */
+   void consume()
+   {
+      if (_holding == false)
+      {
+         return;
+      }
+      _holding = false;
+      _hold.store(NO_HOLD, std::memory_order_release);
+      _consumed.store(_consumed.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+   }
+
+   // Snapshots for either side or a third thread; may be stale on return.
+   // The consumer side is loaded first: both counts only grow, so the later
+   // _head is never behind it, though it may be up to a ring further on.
+   size_t size()
+   {
+      const size_t oldest = _oldest();
+      const size_t head = _head.load(std::memory_order_acquire);
+      return std::min(head - oldest, _capacity);
+   }
+   bool is_empty() { return size() == 0; }
+   bool is_full() { return size() == _capacity; }
+
+   RingStats stats()
+   {
+      RingStats s;
+      s.produced = _produced.load(std::memory_order_relaxed);
+      s.consumed = _consumed.load(std::memory_order_relaxed);
+      s.dropped = _dropped.load(std::memory_order_relaxed);
+      s.overwritten = _overwritten.load(std::memory_order_relaxed);
+      s.depth = size();
+      s.highWater = _highWater.load(std::memory_order_relaxed);
+      return s;
+   }
+
+   // Get maximum capacity
+   size_t capacity() { return _capacity; }
+
+   // Bytes in every block
+   uint32_t blockSize() { return _blockSize; }
+
+private:
+   static constexpr size_t NO_HOLD = SIZE_MAX;
+
+   /* Oldest block still in use: the one being decoded, else the oldest
+    * unread. _tail is loaded first, so a block the consumer has just taken
+    * is always seen through _hold. */
+   size_t _oldest()
+   {
+      size_t tail = _tail.load();
+      return std::min(tail, _hold.load());
+   }
+
+   std::unique_ptr<RTLBuffer[]> _buffer;    // Block descriptors
+   const size_t _capacity;
+   const uint32_t _blockSize;
+   RingPolicy _policy = RingPolicy::DropNewest;
+   std::chrono::milliseconds _timeout{0};
+
+   // Producer side
+   alignas(CACHE_LINE) std::atomic<size_t> _head{0}; // Blocks committed
+   size_t _oldestCache = 0;                          // Producer's last view of _oldest()
+   std::atomic<uint64_t> _produced{0};
+   std::atomic<uint64_t> _dropped{0};
+   std::atomic<uint64_t> _overwritten{0};
+   std::atomic<size_t> _highWater{0};
+
+   // Consumer side; _tail is also advanced by the producer under OverwriteOldest
+   alignas(CACHE_LINE) std::atomic<size_t> _tail{0}; // Oldest block not yet taken
+   std::atomic<size_t> _hold{NO_HOLD};               // Block being decoded
+   size_t _headCache = 0;                            // Consumer's last view of _head
+   size_t _held = 0;
+   bool _holding = false;
+   std::atomic<uint64_t> _consumed{0};
+};
@@ -0,0 +1,92 @@
+/*******************************************************************************
+ * class LatencyHistogram - log-linear histogram of nanosecond durations
+ * Final Project:  Aircraft Detection using Automatic Dependent
+ * Surveillance–Broadcast (ADSB) Data
+ * ECEN 5613 - Spring 2025
+ * University of Colorado Boulder
+*
+********************************************************************************/
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <array>
+#include <algorithm>
+
+/* Every power of two is split into 16 linear buckets, so a value is kept
+ * to within 1/16 (6%) of itself from 1 ns up to the full uint64_t range,
+ * in a fixed 8 kB with no allocation. Written by one thread; read it once
+ * that thread is done or accept a slightly torn snapshot. */
+class LatencyHistogram
+{
+public:
+   void add(uint64_t ns)
+   {
+      _counts[_bucket(ns)]++;
+      _count++;
+      _sum += ns;
+      _min = std::min(_min, ns);
+      _max = std::max(_max, ns);
+   }
+
+   /* Upper bound of the bucket holding the q-quantile (q in [0, 1]),
+    * clamped to the largest value seen. 0 when empty. */
+   uint64_t percentile(double q)
+   {
+      if (_count == 0)
+      {
+         return 0;
+      }
+      uint64_t target = (uint64_t)(q * _count + 0.5);
+      target = std::clamp<uint64_t>(target, 1, _count);
+
+      uint64_t seen = 0;
+      for (size_t i = 0; i < BUCKETS; i++)
+      {
+         seen += _counts[i];
+         if (seen >= target)
+         {
+            return std::min(_upper(i), _max);
+         }
+      }
+      return _max;
+   }
+
+   uint64_t count() { return _count; }
+   uint64_t sum() { return _sum; }
+   uint64_t min() { return _count > 0 ? _min : 0; }
+   uint64_t max() { return _max; }
+   double mean() { return _count > 0 ? (double)_sum / _count : 0; }
+
+private:
+   static constexpr int SUB_BITS = 4;
+   static constexpr uint64_t SUB = 1u << SUB_BITS;
+   static constexpr size_t BUCKETS = (64 - SUB_BITS + 1) * SUB;
+
+   static size_t _bucket(uint64_t ns)
+   {
+      if (ns < SUB)
+      {
+         return ns;
+      }
+      int shift = 63 - __builtin_clzll(ns) - SUB_BITS;
+      return (shift + 1) * SUB + ((ns >> shift) & (SUB - 1));
+   }
+
+   static uint64_t _upper(size_t bucket)
+   {
+      if (bucket < SUB)
+      {
+         return bucket;
+      }
+      int shift = bucket / SUB - 1;
+      uint64_t low = (SUB + bucket % SUB) << shift;
+      return low + ((1ull << shift) - 1);
+   }
+
+   std::array<uint64_t, BUCKETS> _counts{};
+   uint64_t _count = 0;
+   uint64_t _sum = 0;
+   uint64_t _min = UINT64_MAX;
+   uint64_t _max = 0;
+};
@@ -0,0 +1,89 @@
+/*******************************************************************************
+ * class IcaoCache - ICAO addresses heard recently in clean DF11/DF17 frames,
+ * for checking Address/Parity frames, whose parity is XORed with the address
+ * of the aircraft that sent them
+ * Final Project:  Aircraft Detection using Automatic Dependent
+ * Surveillance–Broadcast (ADSB) Data
+ * ECEN 5613 - Spring 2025
+ * University of Colorado Boulder
+*
+********************************************************************************/
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+
+/* A fixed table of 'slots' (a power of two) entries, each the address and
+ * the second it was last heard packed in one 64 bit word, so add() and
+ * seen() can run on different threads at once without a lock. An address
+ * lives in one of PROBES slots from its hash; add() takes the first slot that
+ * holds it, is empty or has expired, and failing that the oldest, so the
+ * table never grows and busy skies just shorten how long an address stays.
+ * Times are in seconds on any clock that does not go backwards. */
+class IcaoCache
+{
+public:
+   static constexpr uint32_t PROBES = 8;
+
+   explicit IcaoCache(uint32_t slots = 1024, uint32_t ttlSeconds = 60)
+       : _slots(new std::atomic<uint64_t>[slots]), _mask(slots - 1), _ttl(ttlSeconds)
+   {
+      for (uint32_t i = 0; i < slots; i++)
+      {
+         _slots[i].store(0, std::memory_order_relaxed);
+      }
+   }
+
+   void add(uint32_t addr, uint32_t now)
+   {
+      const uint64_t entry = _pack(addr, now);
+      const uint32_t home = _hash(addr);
+      uint32_t target = home;
+      uint32_t oldest = UINT32_MAX;
+      for (uint32_t k = 0; k < PROBES; k++)
+      {
+         const uint32_t i = (home + k) & _mask;
+         const uint64_t slot = _slots[i].load(std::memory_order_relaxed);
+         if (slot == 0 || _addr(slot) == addr || _expired(slot, now))
+         {
+            target = i;
+            break;
+         }
+         if (_time(slot) < oldest)
+         {
+            oldest = _time(slot);
+            target = i;
+         }
+      }
+      _slots[target].store(entry, std::memory_order_relaxed);
+   }
+
+   bool seen(uint32_t addr, uint32_t now) const
+   {
+      const uint32_t home = _hash(addr);
+      for (uint32_t k = 0; k < PROBES; k++)
+      {
+         const uint64_t slot = _slots[(home + k) & _mask].load(std::memory_order_relaxed);
+         /* two threads adding one address may each have taken a slot */
+         if (slot != 0 && _addr(slot) == addr && !_expired(slot, now))
+         {
+            return true;
+         }
+      }
+      return false;
+   }
+
+private:
+   /* the time is stored + 1, so that 0 is an empty slot */
+   static uint64_t _pack(uint32_t addr, uint32_t now) { return (uint64_t)(addr & 0xffffff) << 32 | (now + 1); }
+   static uint32_t _addr(uint64_t slot) { return slot >> 32; }
+   static uint32_t _time(uint64_t slot) { return (uint32_t)slot - 1; }
+
+   bool _expired(uint64_t slot, uint32_t now) const { return now - _time(slot) > _ttl; }
+   uint32_t _hash(uint32_t addr) const { return (addr * 0x9E3779B1u >> 12) & _mask; }
+
+   std::unique_ptr<std::atomic<uint64_t>[]> _slots;
+   uint32_t _mask;
+   uint32_t _ttl;
+};
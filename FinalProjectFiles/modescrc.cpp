@@ -0,0 +1,475 @@
+/*******************************************************************************
+ * Mode S CRC - see modescrc.h
+ * Final Project:  Aircraft Detection using Automatic Dependent
+ * Surveillance–Broadcast (ADSB) Data
+ * ECEN 5613 - Spring 2025
+ * University of Colorado Boulder
+*
+********************************************************************************/
+#include "modescrc.h"
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <utility>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+
+/*******************************************************************************
+ * The following table has been imported from the dum1090 library:
+ * https://github.com/antirez/dump1090
+********************************************************************************/
+/* Parity table for MODE S Messages.
+ * The table contains 112 elements, every element corresponds to a bit set
+ * in the message, starting from the first bit of actual data after the
+ * preamble.
+ *
+ * For messages of 112 bit, the whole table is used.
+ * For messages of 56 bits only the last 56 elements are used.
+ *
+ * The algorithm is as simple as xoring all the elements in this table
+ * for which the corresponding bit on the message is set to 1.
+ *
+ * The latest 24 elements in this table are set to 0 as the checksum at the
+ * end of the message should not affect the computation.
+ *
+ * Note: this function can be used with DF11 and DF17, other modes have
+ * the CRC xored with the sender address as they are reply to interrogations,
+ * but a casual listener can't split the address from the checksum.
+ */
+static const uint32_t modes_checksum_table[112] = {
+   0x3935ea, 0x1c9af5, 0xf1b77e, 0x78dbbf, 0xc397db, 0x9e31e9, 0xb0e2f0, 0x587178,
+   0x2c38bc, 0x161c5e, 0x0b0e2f, 0xfa7d13, 0x82c48d, 0xbe9842, 0x5f4c21, 0xd05c14,
+   0x682e0a, 0x341705, 0xe5f186, 0x72f8c3, 0xc68665, 0x9cb936, 0x4e5c9b, 0xd8d449,
+   0x939020, 0x49c810, 0x24e408, 0x127204, 0x093902, 0x049c81, 0xfdb444, 0x7eda22,
+   0x3f6d11, 0xe04c8c, 0x702646, 0x381323, 0xe3f395, 0x8e03ce, 0x4701e7, 0xdc7af7,
+   0x91c77f, 0xb719bb, 0xa476d9, 0xadc168, 0x56e0b4, 0x2b705a, 0x15b82d, 0xf52612,
+   0x7a9309, 0xc2b380, 0x6159c0, 0x30ace0, 0x185670, 0x0c2b38, 0x06159c, 0x030ace,
+   0x018567, 0xff38b7, 0x80665f, 0xbfc92b, 0xa01e91, 0xaff54c, 0x57faa6, 0x2bfd53,
+   0xea04ad, 0x8af852, 0x457c29, 0xdd4410, 0x6ea208, 0x375104, 0x1ba882, 0x0dd441,
+   0xf91024, 0x7c8812, 0x3e4409, 0xe0d800, 0x706c00, 0x383600, 0x1c1b00, 0x0e0d80,
+   0x0706c0, 0x038360, 0x01c1b0, 0x00e0d8, 0x00706c, 0x003836, 0x001c1b, 0xfff409,
+   0x000000, 0x000000, 0x000000, 0x000000, 0x000000, 0x000000, 0x000000, 0x000000,
+   0x000000, 0x000000, 0x000000, 0x000000, 0x000000, 0x000000, 0x000000, 0x000000,
+   0x000000, 0x000000, 0x000000, 0x000000, 0x000000, 0x000000, 0x000000, 0x000000};
+
+/******************************************************************************
+ * Reference: https://github.com/antirez/dump1090
+******************************************************************************/
+uint32_t modesCrcBitwise(const unsigned char *msg, int bits)
+{
+   uint32_t crc = 0;
+   int offset = (bits == 112) ? 0 : (112 - 56);
+   int j;
+
+   for (j = 0; j < bits; j++)
+   {
+      int byte = j / 8;
+      int bit = j % 8;
+      int bitmask = 1 << (7 - bit);
+
+      /* If bit is set, xor with corresponding table entry. */
+      if (msg[byte] & bitmask)
+         crc ^= modes_checksum_table[j + offset];
+   }
+   return crc; /* 24 bit checksum. */
+}
+
+/* Polynomials over GF(2) as integers, bit i the coefficient of x^i; the
+ * first bit of a frame is its highest power, so the big-endian value of
+ * the data bytes is the data polynomial D and the CRC is D * x^24 mod G. */
+static uint32_t polyMod(uint64_t hi, uint64_t lo, int degree)
+{
+   /* (hi * x^64 + lo) mod G, for a dividend of degree < 'degree' */
+   for (int i = degree - 1; i >= 24; i--)
+   {
+      bool set = i >= 64 ? (hi >> (i - 64)) & 1 : (lo >> i) & 1;
+      if (set)
+      {
+         uint64_t g = (uint64_t)MODES_CRC_POLY;
+         int shift = i - 24;
+         if (shift >= 64)
+         {
+            hi ^= g << (shift - 64);
+         }
+         else
+         {
+            lo ^= g << shift;
+            if (shift > 0 && shift + 25 > 64)
+            {
+               hi ^= g >> (64 - shift);
+            }
+         }
+      }
+   }
+   return lo & 0xffffff;
+}
+
+/* floor(x^88 / G), whose x^64 term is implied. */
+static uint64_t barrettMu()
+{
+   uint64_t hi = 1ull << 24, lo = 0; /* x^88 */
+   uint64_t q = 0;
+   for (int i = 88; i >= 24; i--)
+   {
+      bool set = i >= 64 ? (hi >> (i - 64)) & 1 : (lo >> i) & 1;
+      if (set)
+      {
+         int shift = i - 24;
+         if (shift < 64)
+         {
+            q |= 1ull << shift;
+         }
+         uint64_t g = (uint64_t)MODES_CRC_POLY;
+         if (shift >= 64)
+         {
+            hi ^= g << (shift - 64);
+         }
+         else
+         {
+            lo ^= g << shift;
+            if (shift > 0 && shift + 25 > 64)
+            {
+               hi ^= g >> (64 - shift);
+            }
+         }
+      }
+   }
+   return q;
+}
+
+/* One byte at a time: entry b is b * x^24 mod G, shifted in MSB first. */
+struct CrcByteTable
+{
+   uint32_t t[256];
+
+   CrcByteTable()
+   {
+      for (uint32_t b = 0; b < 256; b++)
+      {
+         t[b] = polyMod(0, (uint64_t)b << 24, 32);
+      }
+   }
+};
+
+static uint32_t modesCrcBytewise(const unsigned char *msg, int bits)
+{
+   static const CrcByteTable table;
+   uint32_t crc = 0;
+   for (int i = 0; i < bits / 8 - 3; i++)
+   {
+      crc = ((crc << 8) ^ table.t[(crc >> 16) ^ msg[i]]) & 0xffffff;
+   }
+   return crc;
+}
+
+/* Carry-less multiply: the data is folded to 64 bits with x^64 mod G, and
+ * L * x^24 mod G comes from one Barrett step, q = (L * mu) / x^64 and
+ * crc = q * G mod x^24, exact as L * x^24 has degree < 88. */
+struct CrcConstants
+{
+   uint64_t fold = polyMod(1, 0, 65); /* x^64 mod G */
+   uint64_t mu = barrettMu();
+   uint64_t poly = MODES_CRC_POLY & 0xffffff;
+};
+
+static const CrcConstants &crcConstants()
+{
+   static const CrcConstants c;
+   return c;
+}
+
+/* Data part of the frame split as D = hi * x^64 + lo (hi only for 112). */
+static inline void loadData(const unsigned char *msg, int bits, uint64_t &hi, uint64_t &lo)
+{
+   const int bytes = bits / 8 - 3;
+   const int loBytes = bytes < 8 ? bytes : 8;
+   hi = 0;
+   for (int i = 0; i < bytes - loBytes; i++)
+   {
+      hi = (hi << 8) | msg[i];
+   }
+   lo = 0;
+   for (int i = bytes - loBytes; i < bytes; i++)
+   {
+      lo = (lo << 8) | msg[i];
+   }
+}
+
+#if defined(__x86_64__)
+__attribute__((target("pclmul")))
+static inline __m128i clmul(uint64_t a, uint64_t b)
+{
+   return _mm_clmulepi64_si128(_mm_cvtsi64_si128(a), _mm_cvtsi64_si128(b), 0x00);
+}
+
+__attribute__((target("pclmul")))
+static uint32_t modesCrcPclmul(const unsigned char *msg, int bits)
+{
+   const CrcConstants &c = crcConstants();
+   uint64_t hi, lo;
+   loadData(msg, bits, hi, lo);
+
+   /* hi * x^64 == hi * (x^64 mod G), which has degree < 48 */
+   lo ^= _mm_cvtsi128_si64(clmul(hi, c.fold));
+
+   __m128i p = clmul(lo, c.mu);
+   uint64_t q = _mm_cvtsi128_si64(_mm_srli_si128(p, 8)) ^ lo; /* + lo * x^64 */
+   return _mm_cvtsi128_si64(clmul(q, c.poly)) & 0xffffff;
+}
+#endif
+
+#if defined(__aarch64__)
+__attribute__((target("+crypto")))
+static inline uint64x2_t clmul(uint64_t a, uint64_t b)
+{
+   return vreinterpretq_u64_p128(vmull_p64((poly64_t)a, (poly64_t)b));
+}
+
+__attribute__((target("+crypto")))
+static uint32_t modesCrcPmull(const unsigned char *msg, int bits)
+{
+   const CrcConstants &c = crcConstants();
+   uint64_t hi, lo;
+   loadData(msg, bits, hi, lo);
+
+   lo ^= vgetq_lane_u64(clmul(hi, c.fold), 0);
+
+   uint64_t q = vgetq_lane_u64(clmul(lo, c.mu), 1) ^ lo;
+   return vgetq_lane_u64(clmul(q, c.poly), 0) & 0xffffff;
+}
+#endif
+
+const std::vector<CrcKernel> &crcKernels()
+{
+   static const std::vector<CrcKernel> kernels = [] {
+      std::vector<CrcKernel> k{{"bitwise", modesCrcBitwise}, {"bytewise", modesCrcBytewise}};
+#if defined(__x86_64__)
+      if (__builtin_cpu_supports("pclmul"))
+      {
+         k.push_back({"pclmul", modesCrcPclmul});
+      }
+#endif
+#if defined(__aarch64__)
+      if (getauxval(AT_HWCAP) & HWCAP_PMULL)
+      {
+         k.push_back({"pmull", modesCrcPmull});
+      }
+#endif
+      return k;
+   }();
+   return kernels;
+}
+
+const CrcKernel &bestCrcKernel()
+{
+   return crcKernels().back();
+}
+
+uint32_t modesCrc(const unsigned char *msg, int bits)
+{
+   static const CrcFn best = bestCrcKernel().fn;
+   return best(msg, bits);
+}
+
+uint32_t modesSyndrome(const unsigned char *msg, int bits)
+{
+   const int n = bits / 8;
+   uint32_t parity = ((uint32_t)msg[n - 3] << 16) | ((uint32_t)msg[n - 2] << 8) | msg[n - 1];
+   return parity ^ modesCrc(msg, bits);
+}
+
+/* Syndrome of each bit of a 'bits' long frame flipped on its own: x^n mod G
+ * for a data bit n places above the parity, the bit itself in the parity. */
+static uint32_t bitSyndrome(int bits, int bit)
+{
+   const int power = bits - 1 - bit;
+   if (power < 24)
+   {
+      return 1u << power;
+   }
+   if (power >= 64)
+   {
+      return polyMod(1ull << (power - 64), 0, power + 1);
+   }
+   return polyMod(0, 1ull << power, power + 1);
+}
+
+/* Open addressing from syndrome to the one or two bits behind it. The DF
+ * field is left out, as the frame length was chosen from it. Every such
+ * error has its own syndrome for both lengths, so the first entry for a
+ * syndrome is kept only as a precaution. */
+class CrcErrorTable
+{
+public:
+   explicit CrcErrorTable(int bits)
+   {
+      const int first = 5;
+      const int entries = (bits - first) + (bits - first) * (bits - first - 1) / 2;
+      while (_mask + 1 < (uint32_t)entries * 2)
+      {
+         _mask = _mask * 2 + 1;
+      }
+      _slots.resize(_mask + 1);
+
+      for (int a = first; a < bits; a++)
+      {
+         _insert(bitSyndrome(bits, a), a, -1);
+      }
+      for (int a = first; a < bits; a++)
+      {
+         for (int b = a + 1; b < bits; b++)
+         {
+            _insert(bitSyndrome(bits, a) ^ bitSyndrome(bits, b), a, b);
+         }
+      }
+   }
+
+   int find(uint32_t syndrome, int positions[2]) const
+   {
+      for (uint32_t i = _hash(syndrome);; i = (i + 1) & _mask)
+      {
+         const Slot &slot = _slots[i];
+         if (slot.syndrome == 0)
+         {
+            return 0;
+         }
+         if (slot.syndrome == syndrome)
+         {
+            positions[0] = slot.bit[0];
+            positions[1] = slot.bit[1];
+            return slot.bit[1] < 0 ? 1 : 2;
+         }
+      }
+   }
+
+private:
+   struct Slot
+   {
+      uint32_t syndrome = 0; /* 0: empty, as no error here has that one */
+      int8_t bit[2] = {-1, -1};
+   };
+
+   uint32_t _hash(uint32_t syndrome) const { return (syndrome * 0x9E3779B1u >> 8) & _mask; }
+
+   void _insert(uint32_t syndrome, int a, int b)
+   {
+      uint32_t i = _hash(syndrome);
+      while (_slots[i].syndrome != 0)
+      {
+         if (_slots[i].syndrome == syndrome)
+         {
+            return;
+         }
+         i = (i + 1) & _mask;
+      }
+      _slots[i].syndrome = syndrome;
+      _slots[i].bit[0] = a;
+      _slots[i].bit[1] = b;
+   }
+
+   uint32_t _mask = 255;
+   std::vector<Slot> _slots;
+};
+
+int modesErrorBits(uint32_t syndrome, int bits, int positions[2])
+{
+   static const CrcErrorTable shortTable(56), longTable(112);
+   return (bits == 112 ? longTable : shortTable).find(syndrome, positions);
+}
+
+/* Timed results are stored here so the calls are not dropped. */
+static volatile uint32_t benchmarkSink;
+
+bool benchmarkCrc()
+{
+   const int frames = 100000;
+   std::vector<unsigned char> msgs(frames * 14);
+   std::mt19937 rng(1090);
+   for (auto &b : msgs)
+   {
+      b = rng();
+   }
+
+   bool ok = true;
+   std::cout << "CRC kernels (" << frames << " random frames of 56 and 112 bits):" << std::endl;
+   for (auto &k : crcKernels())
+   {
+      uint32_t mismatches = 0;
+      for (int n = 0; n < frames; n++)
+      {
+         const unsigned char *m = &msgs[n * 14];
+         mismatches += k.fn(m, 56) != modesCrcBitwise(m, 56);
+         mismatches += k.fn(m, 112) != modesCrcBitwise(m, 112);
+      }
+      ok = ok && mismatches == 0;
+
+      const int rounds = 20;
+      auto start = std::chrono::steady_clock::now();
+      for (int r = 0; r < rounds; r++)
+      {
+         for (int n = 0; n < frames; n++)
+         {
+            benchmarkSink = k.fn(&msgs[n * 14], (n & 1) ? 112 : 56);
+         }
+      }
+      double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+      std::cout << "  " << k.name << ": " << (mismatches == 0 ? "identical" : "MISMATCH") << " ("
+                << mismatches << " differ), " << rounds * frames / secs / 1e6 << "M frames/s" << std::endl;
+   }
+
+   /* the same frames made clean, then with one or two bits flipped past
+    * the DF field, and looked up by syndrome */
+   std::vector<uint32_t> syndromes(frames);
+   std::vector<int> flipped(frames * 2);
+   for (int n = 0; n < frames; n++)
+   {
+      unsigned char *m = &msgs[n * 14];
+      const int bits = (n & 1) ? 112 : 56;
+      const uint32_t crc = modesCrc(m, bits);
+      m[bits / 8 - 3] = crc >> 16;
+      m[bits / 8 - 2] = crc >> 8;
+      m[bits / 8 - 1] = crc;
+
+      int a = 5 + rng() % (bits - 5), b = (n & 2) ? 5 + rng() % (bits - 5) : -1;
+      if (b == a)
+      {
+         b = -1;
+      }
+      if (b >= 0 && b < a)
+      {
+         std::swap(a, b);
+      }
+      flipped[n * 2] = a;
+      flipped[n * 2 + 1] = b;
+      m[a / 8] ^= 1 << (7 - a % 8);
+      if (b >= 0)
+      {
+         m[b / 8] ^= 1 << (7 - b % 8);
+      }
+      syndromes[n] = modesSyndrome(m, bits);
+   }
+
+   uint32_t wrong = 0;
+   auto start = std::chrono::steady_clock::now();
+   for (int n = 0; n < frames; n++)
+   {
+      int positions[2];
+      int count = modesErrorBits(syndromes[n], (n & 1) ? 112 : 56, positions);
+      wrong += count != (flipped[n * 2 + 1] < 0 ? 1 : 2) || positions[0] != flipped[n * 2] ||
+               (count == 2 && positions[1] != flipped[n * 2 + 1]);
+   }
+   double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+   ok = ok && wrong == 0;
+
+   std::cout << "Error table (one and two bit errors): " << (wrong == 0 ? "all found" : "MISMATCH") << " ("
+             << wrong << " wrong), " << frames / secs / 1e6 << "M lookups/s" << std::endl;
+   return ok;
+}
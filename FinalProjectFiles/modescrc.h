@@ -0,0 +1,54 @@
+/*******************************************************************************
+ * Mode S CRC - the 24 bit parity of Mode S frames (generator 0x1FFF409),
+ * with the dump1090 bit by bit table walk as the reference, a byte-wise
+ * table, and carry-less multiply versions (PCLMUL, PMULL) picked at run
+ * time.
+ * Final Project:  Aircraft Detection using Automatic Dependent
+ * Surveillance–Broadcast (ADSB) Data
+ * ECEN 5613 - Spring 2025
+ * University of Colorado Boulder
+*
+********************************************************************************/
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+#define MODES_CRC_POLY 0x1FFF409 /* x^24 + ... + 1 */
+
+/* CRC of the data part of a 'bits' long frame (56 or 112), i.e. of all but
+ * the last 24 bits, which carry the parity. */
+typedef uint32_t (*CrcFn)(const unsigned char *msg, int bits);
+
+struct CrcKernel
+{
+   const char *name;
+   CrcFn fn;
+};
+
+/* dump1090's walk over modes_checksum_table, one bit at a time. */
+uint32_t modesCrcBitwise(const unsigned char *msg, int bits);
+
+/* Kernels this CPU can run, the reference first and the fastest last. */
+const std::vector<CrcKernel> &crcKernels();
+const CrcKernel &bestCrcKernel();
+
+/* CRC through the fastest kernel. */
+uint32_t modesCrc(const unsigned char *msg, int bits);
+
+/* The parity field XORed with the CRC of the data: 0 for a clean DF11 or
+ * DF17, the ICAO address for frames whose parity is overlaid with it
+ * (Address/Parity), and for a corrupted frame a value that depends only on
+ * which bits flipped, so it can index an error table. */
+uint32_t modesSyndrome(const unsigned char *msg, int bits);
+
+/* Bits to flip to turn a 'bits' long frame with this (non zero) syndrome
+ * back into a clean one, among every error of one or two bits outside the
+ * DF field: the count (0 when it is none of them), with the positions in
+ * 'positions', bit 0 being the first bit of the frame. */
+int modesErrorBits(uint32_t syndrome, int bits, int positions[2]);
+
+/* Check every kernel against the reference over random frames of both
+ * lengths, and the error table over the same frames with one and two bits
+ * flipped, and time each; prints the results. False on any difference. */
+bool benchmarkCrc();
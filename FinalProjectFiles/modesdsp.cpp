@@ -0,0 +1,680 @@
+/*******************************************************************************
+ * Mode S DSP kernels - see modesdsp.h
+ * Final Project:  Aircraft Detection using Automatic Dependent
+ * Surveillance–Broadcast (ADSB) Data
+ * ECEN 5613 - Spring 2025
+ * University of Colorado Boulder
+*
+********************************************************************************/
+#include "modesdsp.h"
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+/******************************************************************************
+ * Reference: https://github.com/antirez/dump1090
+******************************************************************************/
+/* Populate the I/Q -> Magnitude lookup table. It is used because
+ * sqrt or round may be expensive and performance may vary a lot
+ * depending on the libc used.
+ *
+ * Note that we don't need to fill the table for negative values, as
+ * we square both i and q to take the magnitude. So the maximum absolute
+ * value of i and q is 128, thus the maximum magnitude we get is:
+ *
+ * sqrt(128*128+128*128) = ~181.02
+ *
+ * Then, to retain the full resolution and be able to distinguish among
+ * every pair of I/Q values, we scale this range from the float range
+ * 0-181 to the uint16_t range of 0-65536 by multiplying for 360. */
+struct MagnitudeTable
+{
+   uint16_t m[129][129];
+
+   MagnitudeTable()
+   {
+      for (int i = 0; i <= 128; i++)
+      {
+         for (int q = 0; q <= 128; q++)
+         {
+            m[i][q] = round(sqrt(i * i + q * q) * 360);
+         }
+      }
+   }
+};
+
+static const MagnitudeTable &magnitudeTable()
+{
+   static const MagnitudeTable table;
+   return table;
+}
+
+void magnitudeReference(const uint8_t *iq, uint32_t samples, uint16_t *out)
+{
+   const MagnitudeTable &t = magnitudeTable();
+   for (uint32_t j = 0; j < samples; j++)
+   {
+      int i = iq[2 * j] - 127;
+      int q = iq[2 * j + 1] - 127;
+
+      if (i < 0)
+      {
+         i = -i;
+      }
+      if (q < 0)
+      {
+         q = -q;
+      }
+
+      out[j] = t.m[i][q];
+   }
+}
+
+/* The SIMD kernels take sqrt in single precision, which is off by one from
+ * the table for 26 of the 16641 (i, q) pairs. With s = i^2 + q^2 and
+ * v = round(360 * sqrt(s)), v is exact when v^2 - v < 129600 * s <= v^2 + v
+ * (v > 0), all of which fits in 32 unsigned bits, so each lane is checked
+ * and nudged by one where needed. */
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2")))
+static inline __m256i magnitudeAvx2Lanes(__m256i s)
+{
+   __m256 f = _mm256_sqrt_ps(_mm256_cvtepi32_ps(s));
+   __m256i v = _mm256_cvtps_epi32(_mm256_mul_ps(f, _mm256_set1_ps(360.0f)));
+
+   const __m256i one = _mm256_set1_epi32(1);
+   __m256i x = _mm256_mullo_epi32(s, _mm256_set1_epi32(129600));
+   __m256i hi = _mm256_mullo_epi32(v, _mm256_add_epi32(v, one)); /* v^2 + v */
+   __m256i lo = _mm256_mullo_epi32(v, _mm256_sub_epi32(v, one)); /* v^2 - v */
+
+   /* unsigned a <= b as max(a, b) == b */
+   __m256i under = _mm256_xor_si256(_mm256_cmpeq_epi32(_mm256_max_epu32(x, hi), hi),
+                                    _mm256_set1_epi32(-1));
+   __m256i over = _mm256_andnot_si256(_mm256_cmpeq_epi32(v, _mm256_setzero_si256()),
+                                      _mm256_cmpeq_epi32(_mm256_max_epu32(x, lo), lo));
+   v = _mm256_sub_epi32(v, under); /* mask is -1: v + 1 */
+   v = _mm256_add_epi32(v, over);  /* v - 1 */
+   return v;
+}
+
+/* 16 samples a step: widen the bytes to 16 bits, centre them, and madd
+ * squares and sums each I/Q pair into one 32-bit lane. */
+__attribute__((target("avx2")))
+static void magnitudeAvx2(const uint8_t *iq, uint32_t samples, uint16_t *out)
+{
+   const __m256i centre = _mm256_set1_epi16(127);
+   uint32_t j = 0;
+   for (; j + 16 <= samples; j += 16)
+   {
+      __m256i a = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(iq + 2 * j)));
+      __m256i b = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(iq + 2 * j + 16)));
+      a = _mm256_sub_epi16(a, centre);
+      b = _mm256_sub_epi16(b, centre);
+      __m256i ma = magnitudeAvx2Lanes(_mm256_madd_epi16(a, a));
+      __m256i mb = magnitudeAvx2Lanes(_mm256_madd_epi16(b, b));
+      __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(ma, mb), 0xD8);
+      _mm256_storeu_si256((__m256i *)(out + j), packed);
+   }
+   magnitudeReference(iq + 2 * j, samples - j, out + j);
+}
+#endif
+
+#if defined(__aarch64__)
+static inline uint32x4_t magnitudeNeonLanes(uint32x4_t s)
+{
+   float32x4_t f = vsqrtq_f32(vcvtq_f32_u32(s));
+   uint32x4_t v = vcvtnq_u32_f32(vmulq_n_f32(f, 360.0f));
+
+   const uint32x4_t one = vdupq_n_u32(1);
+   uint32x4_t x = vmulq_n_u32(s, 129600);
+   uint32x4_t hi = vmulq_u32(v, vaddq_u32(v, one)); /* v^2 + v */
+   uint32x4_t lo = vmulq_u32(v, vsubq_u32(v, one)); /* v^2 - v */
+
+   uint32x4_t under = vcgtq_u32(x, hi);
+   uint32x4_t over = vandq_u32(vcleq_u32(x, lo), vtstq_u32(v, v));
+   v = vsubq_u32(v, under); /* mask is all ones: v + 1 */
+   v = vaddq_u32(v, over);  /* v - 1 */
+   return v;
+}
+
+/* 8 samples a step: de-interleave I and Q, centre them, and square and
+ * sum in 32 bits. */
+static void magnitudeNeon(const uint8_t *iq, uint32_t samples, uint16_t *out)
+{
+   const int16x8_t centre = vdupq_n_s16(127);
+   uint32_t j = 0;
+   for (; j + 8 <= samples; j += 8)
+   {
+      uint8x8x2_t p = vld2_u8(iq + 2 * j);
+      int16x8_t i = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(p.val[0])), centre);
+      int16x8_t q = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(p.val[1])), centre);
+      int32x4_t sl = vmlal_s16(vmull_s16(vget_low_s16(i), vget_low_s16(i)), vget_low_s16(q), vget_low_s16(q));
+      int32x4_t sh = vmlal_s16(vmull_s16(vget_high_s16(i), vget_high_s16(i)), vget_high_s16(q), vget_high_s16(q));
+      uint32x4_t ml = magnitudeNeonLanes(vreinterpretq_u32_s32(sl));
+      uint32x4_t mh = magnitudeNeonLanes(vreinterpretq_u32_s32(sh));
+      vst1q_u16(out + j, vcombine_u16(vmovn_u32(ml), vmovn_u32(mh)));
+   }
+   magnitudeReference(iq + 2 * j, samples - j, out + j);
+}
+#endif
+
+/******************************************************************************
+ * Reference: https://github.com/antirez/dump1090
+******************************************************************************/
+/* The Mode S preamble is made of impulses of 0.5 microseconds at
+ * the following time offsets:
+ *
+ * 0   - 0.5 usec: first impulse.
+ * 1.0 - 1.5 usec: second impulse.
+ * 3.5 - 4   usec: third impulse.
+ * 4.5 - 5   usec: last impulse.
+ *
+ * At 2 MHz every sample is 0.5 usec, so this is the first check of
+ * relations between the first 10 samples representing a valid preamble.
+ * Nearly every offset fails it. */
+static inline bool preambleShape(const uint16_t *m)
+{
+   return m[0] > m[1] &&
+          m[1] < m[2] &&
+          m[2] > m[3] &&
+          m[3] < m[0] &&
+          m[4] < m[0] &&
+          m[5] < m[0] &&
+          m[6] < m[0] &&
+          m[7] > m[8] &&
+          m[8] < m[9] &&
+          m[9] > m[6];
+}
+
+uint32_t preambleReference(const uint16_t *m, uint32_t from, uint32_t to)
+{
+   for (uint32_t j = from; j < to; j++)
+   {
+      if (preambleShape(m + j))
+      {
+         return j;
+      }
+   }
+   return to;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+/* 16 offsets a step, one per 16-bit lane: the ten relations are ANDed and
+ * the surviving lanes come out of movemask as bit pairs. AVX2 only
+ * compares signed words, so magnitudes are biased by 0x8000 first. */
+__attribute__((target("avx2")))
+static uint32_t preambleAvx2(const uint16_t *m, uint32_t from, uint32_t to)
+{
+   const __m256i bias = _mm256_set1_epi16((short)0x8000);
+   for (uint32_t j = from; j < to; j += 16)
+   {
+      __m256i s[10];
+      for (int k = 0; k < 10; k++)
+      {
+         s[k] = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(m + j + k)), bias);
+      }
+      __m256i r = _mm256_and_si256(_mm256_cmpgt_epi16(s[0], s[1]), _mm256_cmpgt_epi16(s[2], s[1]));
+      r = _mm256_and_si256(r, _mm256_cmpgt_epi16(s[2], s[3]));
+      r = _mm256_and_si256(r, _mm256_cmpgt_epi16(s[0], s[3]));
+      r = _mm256_and_si256(r, _mm256_cmpgt_epi16(s[0], s[4]));
+      r = _mm256_and_si256(r, _mm256_cmpgt_epi16(s[0], s[5]));
+      r = _mm256_and_si256(r, _mm256_cmpgt_epi16(s[0], s[6]));
+      r = _mm256_and_si256(r, _mm256_cmpgt_epi16(s[7], s[8]));
+      r = _mm256_and_si256(r, _mm256_cmpgt_epi16(s[9], s[8]));
+      r = _mm256_and_si256(r, _mm256_cmpgt_epi16(s[9], s[6]));
+
+      uint32_t mask = _mm256_movemask_epi8(r);
+      if (mask != 0)
+      {
+         uint32_t hit = j + __builtin_ctz(mask) / 2;
+         return hit < to ? hit : to;
+      }
+   }
+   return to;
+}
+#endif
+
+#if defined(__aarch64__)
+/* 8 offsets a step; lane k of the ANDed relations is weighted 1 << k and
+ * summed across the vector to get the candidate mask. */
+static uint32_t preambleNeon(const uint16_t *m, uint32_t from, uint32_t to)
+{
+   static const uint16_t weights[8] = {1, 2, 4, 8, 16, 32, 64, 128};
+   const uint16x8_t w = vld1q_u16(weights);
+   for (uint32_t j = from; j < to; j += 8)
+   {
+      uint16x8_t s[10];
+      for (int k = 0; k < 10; k++)
+      {
+         s[k] = vld1q_u16(m + j + k);
+      }
+      uint16x8_t r = vandq_u16(vcgtq_u16(s[0], s[1]), vcgtq_u16(s[2], s[1]));
+      r = vandq_u16(r, vcgtq_u16(s[2], s[3]));
+      r = vandq_u16(r, vcgtq_u16(s[0], s[3]));
+      r = vandq_u16(r, vcgtq_u16(s[0], s[4]));
+      r = vandq_u16(r, vcgtq_u16(s[0], s[5]));
+      r = vandq_u16(r, vcgtq_u16(s[0], s[6]));
+      r = vandq_u16(r, vcgtq_u16(s[7], s[8]));
+      r = vandq_u16(r, vcgtq_u16(s[9], s[8]));
+      r = vandq_u16(r, vcgtq_u16(s[9], s[6]));
+
+      uint32_t mask = vaddvq_u16(vandq_u16(r, w));
+      if (mask != 0)
+      {
+         uint32_t hit = j + __builtin_ctz(mask);
+         return hit < to ? hit : to;
+      }
+   }
+   return to;
+}
+#endif
+
+/******************************************************************************
+ * Reference: https://github.com/antirez/dump1090
+******************************************************************************/
+void sliceReference(const uint16_t *m, SlicedFrame &frame)
+{
+   unsigned char bits[112];
+   int i, low, high, delta;
+
+   /* Decode all the next 112 bits, regardless of the actual message
+    * size. We'll check the actual message type later. */
+   frame.errors = 0;
+   frame.shortDelta = 0;
+   frame.longDelta = 0;
+   for (i = 0; i < 112 * 2; i += 2)
+   {
+      low = m[i];
+      high = m[i + 1];
+      delta = low - high;
+      if (delta < 0)
+         delta = -delta;
+
+      frame.longDelta += delta;
+      if (i < 56 * 2)
+         frame.shortDelta += delta;
+
+      if (i > 0 && delta < 256)
+      {
+         bits[i / 2] = bits[i / 2 - 1];
+      }
+      else if (low == high)
+      {
+         /* Checking if two adiacent samples have the same magnitude
+          * is an effective way to detect if it's just random noise
+          * that was detected as a valid preamble. */
+         bits[i / 2] = 2; /* error */
+         if (i < 56 * 2)
+            frame.errors++;
+      }
+      else if (low > high)
+      {
+         bits[i / 2] = 1;
+      }
+      else
+      {
+         /* (low < high) for exclusion  */
+         bits[i / 2] = 0;
+      }
+   }
+
+   /* Pack bits into bytes */
+   for (i = 0; i < 112; i += 8)
+   {
+      frame.msg[i / 8] =
+          bits[i] << 7 |
+          bits[i + 1] << 6 |
+          bits[i + 2] << 5 |
+          bits[i + 3] << 4 |
+          bits[i + 4] << 3 |
+          bits[i + 5] << 2 |
+          bits[i + 6] << 1 |
+          bits[i + 7];
+   }
+}
+
+/* The SIMD slicers decide every bit period at once into 128-bit masks,
+ * bit k for period k: 'raw' (low > high) and 'carry' (|low - high| < 256,
+ * which repeats the previous bit). Resolving the carries is a segmented
+ * copy done by doubling, seven shifts for 112 bits, and each byte is then
+ * bit-reversed into the MSB-first message.
+ *
+ * low == high is only an error at period 0; after that it is a carry. An
+ * error there also makes the reference pack 2s, which shifts the bits it
+ * covers, so those (rare) frames go to the reference to stay identical. */
+__extension__ typedef unsigned __int128 BitMask128;
+
+static inline BitMask128 resolveCarries(BitMask128 raw, BitMask128 carry)
+{
+   BitMask128 known = ~carry | 1;
+   BitMask128 bits = raw & known;
+   for (int s = 1; s < 128; s *= 2)
+   {
+      bits |= (bits << s) & ~known;
+      known |= known << s;
+   }
+   return bits;
+}
+
+struct ReverseTable
+{
+   uint8_t r[256];
+
+   ReverseTable()
+   {
+      for (int b = 0; b < 256; b++)
+      {
+         uint8_t v = 0;
+         for (int i = 0; i < 8; i++)
+         {
+            v |= ((b >> i) & 1) << (7 - i);
+         }
+         r[b] = v;
+      }
+   }
+};
+
+static void packBits(BitMask128 bits, unsigned char *msg)
+{
+   static const ReverseTable reverse;
+   for (int b = 0; b < 14; b++)
+   {
+      msg[b] = reverse.r[(uint8_t)(bits >> (8 * b))];
+   }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2")))
+static inline uint32_t horizontalSum(__m256i v)
+{
+   __m128i s = _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+   s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0x4E));
+   s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0xB1));
+   return _mm_cvtsi128_si32(s);
+}
+
+/* 8 bit periods a step: each 32-bit lane holds one low / high pair. */
+__attribute__((target("avx2")))
+static void sliceAvx2(const uint16_t *m, SlicedFrame &frame)
+{
+   if (m[0] == m[1])
+   {
+      sliceReference(m, frame);
+      return;
+   }
+
+   const __m256i word = _mm256_set1_epi32(0xffff);
+   const __m256i threshold = _mm256_set1_epi32(256);
+   BitMask128 raw = 0;
+   BitMask128 carry = 0;
+   __m256i sum = _mm256_setzero_si256();
+   for (int v = 0; v < 14; v++)
+   {
+      __m256i pairs = _mm256_loadu_si256((const __m256i *)(m + 16 * v));
+      __m256i low = _mm256_and_si256(pairs, word);
+      __m256i high = _mm256_srli_epi32(pairs, 16);
+      __m256i delta = _mm256_abs_epi32(_mm256_sub_epi32(low, high));
+
+      raw |= (BitMask128)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(low, high))) << (8 * v);
+      carry |= (BitMask128)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(threshold, delta))) << (8 * v);
+      sum = _mm256_add_epi32(sum, delta);
+      if (v == 6)
+      {
+         frame.shortDelta = horizontalSum(sum);
+      }
+   }
+   frame.longDelta = horizontalSum(sum);
+   frame.errors = 0;
+   packBits(resolveCarries(raw, carry & ~(BitMask128)1), frame.msg);
+}
+#endif
+
+#if defined(__aarch64__)
+/* 8 bit periods a step: vld2 splits the lows from the highs. */
+static void sliceNeon(const uint16_t *m, SlicedFrame &frame)
+{
+   if (m[0] == m[1])
+   {
+      sliceReference(m, frame);
+      return;
+   }
+
+   static const uint16_t weights[8] = {1, 2, 4, 8, 16, 32, 64, 128};
+   const uint16x8_t w = vld1q_u16(weights);
+   const uint16x8_t threshold = vdupq_n_u16(256);
+   BitMask128 raw = 0;
+   BitMask128 carry = 0;
+   uint32_t sum = 0;
+   for (int v = 0; v < 14; v++)
+   {
+      uint16x8x2_t pairs = vld2q_u16(m + 16 * v);
+      uint16x8_t delta = vabdq_u16(pairs.val[0], pairs.val[1]);
+
+      raw |= (BitMask128)vaddvq_u16(vandq_u16(vcgtq_u16(pairs.val[0], pairs.val[1]), w)) << (8 * v);
+      carry |= (BitMask128)vaddvq_u16(vandq_u16(vcltq_u16(delta, threshold), w)) << (8 * v);
+      sum += vaddlvq_u16(delta);
+      if (v == 6)
+      {
+         frame.shortDelta = sum;
+      }
+   }
+   frame.longDelta = sum;
+   frame.errors = 0;
+   packBits(resolveCarries(raw, carry & ~(BitMask128)1), frame.msg);
+}
+#endif
+
+const std::vector<MagnitudeKernel> &magnitudeKernels()
+{
+   static const std::vector<MagnitudeKernel> kernels = [] {
+      std::vector<MagnitudeKernel> k{{"lookup table", magnitudeReference}};
+#if defined(__x86_64__) || defined(__i386__)
+      if (__builtin_cpu_supports("avx2"))
+      {
+         k.push_back({"avx2", magnitudeAvx2});
+      }
+#endif
+#if defined(__aarch64__)
+      k.push_back({"neon", magnitudeNeon});
+#endif
+      return k;
+   }();
+   return kernels;
+}
+
+const MagnitudeKernel &bestMagnitudeKernel()
+{
+   return magnitudeKernels().back();
+}
+
+const std::vector<PreambleKernel> &preambleKernels()
+{
+   static const std::vector<PreambleKernel> kernels = [] {
+      std::vector<PreambleKernel> k{{"scalar", preambleReference}};
+#if defined(__x86_64__) || defined(__i386__)
+      if (__builtin_cpu_supports("avx2"))
+      {
+         k.push_back({"avx2", preambleAvx2});
+      }
+#endif
+#if defined(__aarch64__)
+      k.push_back({"neon", preambleNeon});
+#endif
+      return k;
+   }();
+   return kernels;
+}
+
+const PreambleKernel &bestPreambleKernel()
+{
+   return preambleKernels().back();
+}
+
+const std::vector<SliceKernel> &sliceKernels()
+{
+   static const std::vector<SliceKernel> kernels = [] {
+      std::vector<SliceKernel> k{{"scalar", sliceReference}};
+#if defined(__x86_64__) || defined(__i386__)
+      if (__builtin_cpu_supports("avx2"))
+      {
+         k.push_back({"avx2", sliceAvx2});
+      }
+#endif
+#if defined(__aarch64__)
+      k.push_back({"neon", sliceNeon});
+#endif
+      return k;
+   }();
+   return kernels;
+}
+
+const SliceKernel &bestSliceKernel()
+{
+   return sliceKernels().back();
+}
+
+/* Timed results are stored here so the calls are not dropped. */
+static volatile unsigned char benchmarkSink;
+
+bool benchmarkKernels()
+{
+   /* every I/Q byte pair once */
+   std::vector<uint8_t> all(65536 * 2);
+   for (uint32_t n = 0; n < 65536; n++)
+   {
+      all[2 * n] = n >> 8;
+      all[2 * n + 1] = n & 0xff;
+   }
+   std::vector<uint16_t> expected(65536);
+   magnitudeReference(all.data(), 65536, expected.data());
+
+   /* a block of noise the size of a default ADS-B block */
+   const uint32_t samples = 163840;
+   std::vector<uint8_t> block(samples * 2);
+   std::mt19937 rng(1090);
+   std::normal_distribution<float> noise(127.0f, 20.0f);
+   for (auto &b : block)
+   {
+      b = (uint8_t)std::min(255.0f, std::max(0.0f, noise(rng)));
+   }
+   std::vector<uint16_t> out(std::max<uint32_t>(65536, samples));
+
+   const int rounds = 200;
+   bool ok = true;
+   std::cout << "Magnitude kernels (" << samples << " samples a block):" << std::endl;
+   for (auto &k : magnitudeKernels())
+   {
+      k.fn(all.data(), 65536, out.data());
+      uint32_t mismatches = 0;
+      for (uint32_t n = 0; n < 65536; n++)
+      {
+         mismatches += out[n] != expected[n];
+      }
+      ok = ok && mismatches == 0;
+
+      auto start = std::chrono::steady_clock::now();
+      for (int r = 0; r < rounds; r++)
+      {
+         k.fn(block.data(), samples, out.data());
+      }
+      double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+      std::cout << "  " << k.name << ": " << (mismatches == 0 ? "bit exact" : "MISMATCH")
+                << " (" << mismatches << " of 65536 differ), "
+                << rounds * (double)samples / secs / 1e6 << " MS/s" << std::endl;
+   }
+
+   /* every candidate offset in the noise block, as detectModeS walks them */
+   std::vector<uint16_t> m(samples);
+   magnitudeReference(block.data(), samples, m.data());
+   const uint32_t to = samples - 240;
+   auto candidates = [&](PreambleFn fn, std::vector<uint32_t> &found) {
+      found.clear();
+      for (uint32_t j = fn(m.data(), 0, to); j < to; j = fn(m.data(), j + 1, to))
+      {
+         found.push_back(j);
+      }
+   };
+   std::vector<uint32_t> reference;
+   candidates(preambleReference, reference);
+
+   std::cout << "Preamble kernels (" << to << " offsets a block, " << reference.size()
+             << " candidates):" << std::endl;
+   for (auto &k : preambleKernels())
+   {
+      std::vector<uint32_t> found;
+      candidates(k.fn, found);
+      bool same = found == reference;
+      ok = ok && same;
+
+      auto start = std::chrono::steady_clock::now();
+      for (int r = 0; r < rounds; r++)
+      {
+         candidates(k.fn, found);
+      }
+      double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+      std::cout << "  " << k.name << ": " << (same ? "same candidates" : "MISMATCH") << ", "
+                << rounds * (double)to / secs / 1e6 << "M offsets/s" << std::endl;
+   }
+
+   /* a frame sliced at every 3rd offset, and a few with an error at bit 0 */
+   std::vector<uint32_t> offsets;
+   for (uint32_t j = 0; j < to; j += 3)
+   {
+      offsets.push_back(j);
+   }
+   for (uint32_t j = 1; j < to; j += 997)
+   {
+      m[j + 1] = m[j];
+      offsets.push_back(j);
+   }
+   std::vector<SlicedFrame> expectedFrames(offsets.size());
+   for (size_t n = 0; n < offsets.size(); n++)
+   {
+      sliceReference(m.data() + offsets[n], expectedFrames[n]);
+   }
+
+   std::cout << "Slice kernels (" << offsets.size() << " candidates):" << std::endl;
+   for (auto &k : sliceKernels())
+   {
+      uint32_t mismatches = 0;
+      SlicedFrame f;
+      for (size_t n = 0; n < offsets.size(); n++)
+      {
+         k.fn(m.data() + offsets[n], f);
+         const SlicedFrame &e = expectedFrames[n];
+         mismatches += memcmp(f.msg, e.msg, sizeof(f.msg)) != 0 || f.errors != e.errors ||
+                       f.shortDelta != e.shortDelta || f.longDelta != e.longDelta;
+      }
+      ok = ok && mismatches == 0;
+
+      const int sliceRounds = 20;
+      auto start = std::chrono::steady_clock::now();
+      for (int r = 0; r < sliceRounds; r++)
+      {
+         for (uint32_t j : offsets)
+         {
+            k.fn(m.data() + j, f);
+            benchmarkSink = f.msg[0];
+         }
+      }
+      double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+      std::cout << "  " << k.name << ": " << (mismatches == 0 ? "identical" : "MISMATCH") << " ("
+                << mismatches << " differ), " << sliceRounds * offsets.size() / secs / 1e6
+                << "M candidates/s" << std::endl;
+   }
+   return ok;
+}
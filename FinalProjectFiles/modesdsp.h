@@ -0,0 +1,82 @@
+/*******************************************************************************
+ * Mode S DSP kernels - the per-sample inner loops of the ADS-B demodulator,
+ * each with a portable reference version and SIMD versions (AVX2, NEON)
+ * picked at run time for the CPU the program is running on.
+ * Final Project:  Aircraft Detection using Automatic Dependent
+ * Surveillance–Broadcast (ADSB) Data
+ * ECEN 5613 - Spring 2025
+ * University of Colorado Boulder
+*
+********************************************************************************/
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+/* Magnitude of 'samples' u8 I/Q pairs: with i = |I - 127| and
+ * q = |Q - 127|, out = round(sqrt(i^2 + q^2) * 360), which spreads the
+ * 0 - 181 range over the uint16_t range. */
+typedef void (*MagnitudeFn)(const uint8_t *iq, uint32_t samples, uint16_t *out);
+
+struct MagnitudeKernel
+{
+   const char *name;
+   MagnitudeFn fn;
+};
+
+/* The lookup table version every other kernel must match bit for bit. */
+void magnitudeReference(const uint8_t *iq, uint32_t samples, uint16_t *out);
+
+/* Kernels this CPU can run, the reference first and the fastest last. */
+const std::vector<MagnitudeKernel> &magnitudeKernels();
+
+/* The fastest kernel for this CPU. */
+const MagnitudeKernel &bestMagnitudeKernel();
+
+/* First offset j in [from, to) where m[j] .. m[j + 9] have the shape of a
+ * Mode S preamble (see preambleReference), or 'to' when there is none.
+ * May read up to m[to + 24]. */
+typedef uint32_t (*PreambleFn)(const uint16_t *m, uint32_t from, uint32_t to);
+
+struct PreambleKernel
+{
+   const char *name;
+   PreambleFn fn;
+};
+
+/* The scalar test detectModeS() used at every offset. */
+uint32_t preambleReference(const uint16_t *m, uint32_t from, uint32_t to);
+
+const std::vector<PreambleKernel> &preambleKernels();
+const PreambleKernel &bestPreambleKernel();
+
+/* The 112 bit periods after a preamble, decided. */
+struct SlicedFrame
+{
+   unsigned char msg[14]; /* MODES_LONG_MSG_BYTES */
+   int errors;            /* demod errors in the first 56 bits */
+   uint32_t shortDelta;   /* sum of |low - high| over the first 56 bits */
+   uint32_t longDelta;    /* and over all 112 */
+};
+
+/* 'm' points at the first sample after the preamble. */
+typedef void (*SliceFn)(const uint16_t *m, SlicedFrame &frame);
+
+struct SliceKernel
+{
+   const char *name;
+   SliceFn fn;
+};
+
+/* The bit by bit slicer and packer detectModeS() used. */
+void sliceReference(const uint16_t *m, SlicedFrame &frame);
+
+const std::vector<SliceKernel> &sliceKernels();
+const SliceKernel &bestSliceKernel();
+
+/* Check every kernel against its reference (magnitudes over all 65536 I/Q
+ * byte pairs, preamble candidates and sliced frames over a block of noise)
+ * and time each; prints the results. False if any kernel differs from the
+ * reference. */
+bool benchmarkKernels();
@@ -0,0 +1,200 @@
+/*******************************************************************************
+ * ModesFrame field accessors - see modesframe.h
+ * Final Project:  Aircraft Detection using Automatic Dependent
+ * Surveillance–Broadcast (ADSB) Data
+ * ECEN 5613 - Spring 2025
+ * University of Colorado Boulder
+*
+********************************************************************************/
+#include "modesframe.h"
+#include <math.h>
+
+/******************************************************************************
+ * Reference: https://github.com/antirez/dump1090
+******************************************************************************/
+int ModesFrame::squawk() const
+{
+   const unsigned char *msg = _msg;
+
+   /* In the squawk (identity) field bits are interleaved like that
+    * (message bit 20 to bit 32):
+    *
+    * C1-A1-C2-A2-C4-A4-ZERO-B1-D1-B2-D2-B4-D4
+    *
+    * So every group of three bits A, B, C, D represent an integer
+    * from 0 to 7.
+    *
+    * The actual meaning is just 4 octal numbers, but we convert it
+    * into a base ten number tha happens to represent the four
+    * octal numbers.
+    *
+    * For more info: http://en.wikipedia.org/wiki/Gillham_code */
+   int a, b, c, d;
+
+   a = ((msg[3] & 0x80) >> 5) |
+       ((msg[2] & 0x02) >> 0) |
+       ((msg[2] & 0x08) >> 3);
+   b = ((msg[3] & 0x02) << 1) |
+       ((msg[3] & 0x08) >> 2) |
+       ((msg[3] & 0x20) >> 5);
+   c = ((msg[2] & 0x01) << 2) |
+       ((msg[2] & 0x04) >> 1) |
+       ((msg[2] & 0x10) >> 4);
+   d = ((msg[3] & 0x01) << 2) |
+       ((msg[3] & 0x04) >> 1) |
+       ((msg[3] & 0x10) >> 4);
+   return a * 1000 + b * 100 + c * 10 + d;
+}
+
+int ModesFrame::altitude(int *unit) const
+{
+   int ignored;
+   if (unit == nullptr)
+   {
+      unit = &ignored;
+   }
+   *unit = MODES_UNIT_FEET;
+
+   const int t = df();
+   if (t == 0 || t == 4 || t == 16 || t == 20)
+   {
+      return decodeAC13Field(_msg, unit);
+   }
+   if (isPosition())
+   {
+      return decodeAC12Field(_msg, unit);
+   }
+   return 0;
+}
+
+/******************************************************************************
+ * Reference: https://github.com/antirez/dump1090
+******************************************************************************/
+void ModesFrame::callsign(char flight[9]) const
+{
+   static const char *ais_charset = "?ABCDEFGHIJKLMNOPQRSTUVWXYZ????? ???????????????0123456789??????";
+   const unsigned char *msg = _msg;
+
+   flight[0] = ais_charset[msg[5] >> 2];
+   flight[1] = ais_charset[((msg[5] & 3) << 4) | (msg[6] >> 4)];
+   flight[2] = ais_charset[((msg[6] & 15) << 2) | (msg[7] >> 6)];
+   flight[3] = ais_charset[msg[7] & 63];
+   flight[4] = ais_charset[msg[8] >> 2];
+   flight[5] = ais_charset[((msg[8] & 3) << 4) | (msg[9] >> 4)];
+   flight[6] = ais_charset[((msg[9] & 15) << 2) | (msg[10] >> 6)];
+   flight[7] = ais_charset[msg[10] & 63];
+   flight[8] = '\0';
+}
+
+/******************************************************************************
+ * Reference: https://github.com/antirez/dump1090
+******************************************************************************/
+int ModesFrame::velocity() const
+{
+   if (df() != 17 || metype() != 19 || (mesub() != 1 && mesub() != 2))
+   {
+      return 0;
+   }
+   int ew_velocity = ((_msg[5] & 3) << 8) | _msg[6];
+   int ns_velocity = ((_msg[7] & 0x7f) << 3) | ((_msg[8] & 0xe0) >> 5);
+
+   /* Compute velocity from the two speed components. */
+   return sqrt(ns_velocity * ns_velocity + ew_velocity * ew_velocity);
+}
+
+int ModesFrame::heading() const
+{
+   if (df() != 17 || metype() != 19)
+   {
+      return 0;
+   }
+   if (mesub() == 3 || mesub() == 4)
+   {
+      return (360.0 / 128) * (((_msg[5] & 3) << 5) | (_msg[6] >> 3));
+   }
+   if (mesub() != 1 && mesub() != 2)
+   {
+      return 0;
+   }
+
+   int ewv = ((_msg[5] & 3) << 8) | _msg[6];
+   int nsv = ((_msg[7] & 0x7f) << 3) | ((_msg[8] & 0xe0) >> 5);
+   if (ewv == 0 && nsv == 0)
+   {
+      return 0;
+   }
+   if (_msg[5] & 4) /* West */
+      ewv *= -1;
+   if (_msg[7] & 0x80) /* South */
+      nsv *= -1;
+
+   /* Convert to degrees. We don't want negative values but a 0-360 scale. */
+   int heading = atan2(ewv, nsv) * 360 / (M_PI * 2);
+   if (heading < 0)
+      heading += 360;
+   return heading;
+}
+
+/******************************************************************************
+ * Reference: https://github.com/antirez/dump1090
+******************************************************************************/
+/* Decode the 12 bit AC altitude field (in DF 17 and others).
+ * Returns the altitude or 0 if it can't be decoded. */
+int decodeAC12Field(const unsigned char *msg, int *unit)
+{
+   int q_bit = msg[5] & 1;
+
+   if (q_bit)
+   {
+      /* N is the 11 bit integer resulting from the removal of bit
+       * Q */
+      *unit = MODES_UNIT_FEET;
+      int n = ((msg[5] >> 1) << 4) | ((msg[6] & 0xF0) >> 4);
+      /* The final altitude is due to the resulting number multiplied
+       * by 25, minus 1000. */
+      return n * 25 - 1000;
+   }
+   else
+   {
+      return 0;
+   }
+}
+
+/******************************************************************************
+ * Reference: https://github.com/antirez/dump1090
+******************************************************************************/
+/* Decode the 13 bit AC altitude field (in DF 20 and others).
+ * Returns the altitude, and set 'unit' to either MODES_UNIT_METERS
+ * or MDOES_UNIT_FEETS. */
+int decodeAC13Field(const unsigned char *msg, int *unit)
+{
+   int m_bit = msg[3] & (1 << 6);
+   int q_bit = msg[3] & (1 << 4);
+
+   if (!m_bit)
+   {
+      *unit = MODES_UNIT_FEET;
+      if (q_bit)
+      {
+         /* N is the 11 bit integer resulting from the removal of bit
+          * Q and M */
+         int n = ((msg[2] & 31) << 6) |
+                 ((msg[3] & 0x80) >> 2) |
+                 ((msg[3] & 0x20) >> 1) |
+                 (msg[3] & 15);
+         /* The final altitude is due to the resulting number multiplied
+          * by 25, minus 1000. */
+         return n * 25 - 1000;
+      }
+      else
+      {
+         /* TODO: Implement altitude where Q=0 and M=0 */
+      }
+   }
+   else
+   {
+      *unit = MODES_UNIT_METERS;
+      /* TODO: Implement altitude when meter unit is selected. */
+   }
+   return 0;
+}
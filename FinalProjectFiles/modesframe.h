@@ -0,0 +1,102 @@
+/*******************************************************************************
+ * class ModesFrame - a Mode S frame that passed its parity check, kept as the
+ * 14 bytes received, with every field decoded from them only when asked for
+ * Final Project:  Aircraft Detection using Automatic Dependent
+ * Surveillance–Broadcast (ADSB) Data
+ * ECEN 5613 - Spring 2025
+ * University of Colorado Boulder
+*
+********************************************************************************/
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#define MODES_UNIT_FEET 0
+#define MODES_UNIT_METERS 1
+
+/* Besides the bytes (after any bit repair) it holds what checking the parity
+ * found out: the sender's address, which for the Address/Parity formats is
+ * not in the bytes, and the repaired bits. At 24 bytes it goes through the
+ * frame queue by value, where a modesMessage with every field filled takes
+ * 164; Adsb::decodeModesMessage() still fills one, for display. */
+class ModesFrame
+{
+public:
+   ModesFrame() = default;
+
+   ModesFrame(const unsigned char *msg, uint32_t icao, int errorbit = -1, int errorbit2 = -1)
+       : _icao(icao), _errorbit(errorbit), _errorbit2(errorbit2)
+   {
+      memcpy(_msg, msg, sizeof(_msg));
+   }
+
+   const unsigned char *data() const { return _msg; }
+
+   int df() const { return _msg[0] >> 3; } /* Downlink Format */
+   int bits() const
+   {
+      const int t = df();
+      return (t == 16 || t == 17 || t == 19 || t == 20 || t == 21) ? 112 : 56;
+   }
+   uint32_t icao() const { return _icao; }
+
+   /* Parity field, the last three bytes */
+   uint32_t parity() const
+   {
+      const int n = bits() / 8;
+      return ((uint32_t)_msg[n - 3] << 16) | ((uint32_t)_msg[n - 2] << 8) | _msg[n - 1];
+   }
+   int errorbit() const { return _errorbit; }   /* -1 if none was repaired */
+   int errorbit2() const { return _errorbit2; } /* -1 unless two were */
+
+   /* DF11, DF17 */
+   int ca() const { return _msg[0] & 7; } /* Responder capabilities */
+
+   /* DF4, DF5, DF20, DF21 */
+   int fs() const { return _msg[0] & 7; } /* Flight status */
+   int dr() const { return _msg[1] >> 3 & 31; }
+   int um() const { return ((_msg[1] & 7) << 3) | _msg[2] >> 5; }
+
+   /* DF5, DF21: Mode A code as four octal digits written in base ten */
+   int squawk() const;
+
+   /* DF0/4/16/20 (13 bit field) and DF17 airborne positions (12 bit field):
+    * the altitude, 0 if the format has none or it can't be decoded. 'unit'
+    * gets MODES_UNIT_FEET or MODES_UNIT_METERS. */
+   int altitude(int *unit = nullptr) const;
+
+   /* DF17 */
+   int metype() const { return _msg[4] >> 3; } /* Extended squitter type */
+   int mesub() const { return _msg[4] & 7; }
+   bool isPosition() const { return df() == 17 && metype() >= 9 && metype() <= 18; }
+
+   /* Airborne position (TC 9 - 18) */
+   bool cprOdd() const { return _msg[6] & (1 << 2); }
+   bool utcSync() const { return _msg[6] & (1 << 3); }
+   int rawLatitude() const { return ((_msg[6] & 3) << 15) | (_msg[7] << 7) | (_msg[8] >> 1); }
+   int rawLongitude() const { return ((_msg[8] & 1) << 16) | (_msg[9] << 8) | _msg[10]; }
+
+   /* Identification (TC 1 - 4): 8 characters and a terminating 0 */
+   void callsign(char flight[9]) const;
+
+   /* Airborne velocity (TC 19): ground speed in knots (subtypes 1, 2) and
+    * heading in degrees 0 - 359 (subtypes 1 - 4), 0 otherwise */
+   int velocity() const;
+   int heading() const;
+
+private:
+   unsigned char _msg[14] = {}; /* MODES_LONG_MSG_BYTES */
+   uint32_t _icao = 0;
+   int8_t _errorbit = -1;
+   int8_t _errorbit2 = -1;
+};
+
+/* Decode the 12 bit AC altitude field (in DF 17 and others).
+ * Returns the altitude or 0 if it can't be decoded. */
+int decodeAC12Field(const unsigned char *msg, int *unit);
+
+/* Decode the 13 bit AC altitude field (in DF 20 and others).
+ * Returns the altitude, and set 'unit' to either MODES_UNIT_METERS
+ * or MDOES_UNIT_FEETS. */
+int decodeAC13Field(const unsigned char *msg, int *unit);
@@ -0,0 +1,223 @@
+/*******************************************************************************
+ * class Pipeline - the processing graph: stages (nodes) that each run as a
+ * Sequencer service with their own CPU, priority and period, and the
+ * bounded lock-free queues (edges) that carry data between them.
+ * Final Project:  Aircraft Detection using Automatic Dependent
+ * Surveillance–Broadcast (ADSB) Data
+ * ECEN 5613 - Spring 2025
+ * University of Colorado Boulder
+*
+********************************************************************************/
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <syslog.h>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Sequencer.hpp"
+#include "circularbuffer.h"
+
+/* Bounded single-producer / single-consumer queue of values, for edges that
+ * carry small items (frames, snapshots) rather than capture blocks, which
+ * use CircularBuffer. Same publication rules: push() makes an item visible
+ * with a release store of _head, pop() frees its slot with one of _tail.
+ * A full queue drops the new item and counts it. */
+template <typename T>
+class SpscQueue
+{
+public:
+   explicit SpscQueue(size_t capacity) : _items(new T[capacity]()), _capacity(capacity) {}
+
+   /* Producer. False, and counted as dropped, when the queue is full. */
+   bool push(T item)
+   {
+      const size_t head = _head.load(std::memory_order_relaxed);
+      if (head - _tailCache == _capacity)
+      {
+         _tailCache = _tail.load(std::memory_order_acquire);
+         if (head - _tailCache == _capacity)
+         {
+            _dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+         }
+      }
+      _items[head % _capacity] = std::move(item);
+      _head.store(head + 1, std::memory_order_release);
+      _produced.store(_produced.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+      // _tailCache is only refreshed when the queue looks full, so it
+      // would make every queue reach its capacity sooner or later
+      size_t depth = head + 1 - _tail.load(std::memory_order_acquire);
+      if (depth > _highWater.load(std::memory_order_relaxed))
+      {
+         _highWater.store(depth, std::memory_order_relaxed);
+      }
+      return true;
+   }
+
+   /* Consumer. False when the queue is empty. */
+   bool pop(T &item)
+   {
+      const size_t tail = _tail.load(std::memory_order_relaxed);
+      if (tail == _headCache)
+      {
+         _headCache = _head.load(std::memory_order_acquire);
+         if (tail == _headCache)
+         {
+            return false;
+         }
+      }
+      item = std::move(_items[tail % _capacity]);
+      _tail.store(tail + 1, std::memory_order_release);
+      _consumed.store(_consumed.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+      return true;
+   }
+
+   /* Either side or a third thread. _tail is loaded first so the later
+    * _head is never behind it; it may be up to a queue further on. */
+   size_t size()
+   {
+      const size_t tail = _tail.load(std::memory_order_acquire);
+      const size_t head = _head.load(std::memory_order_acquire);
+      return std::min(head - tail, _capacity);
+   }
+   size_t capacity() { return _capacity; }
+
+   RingStats stats()
+   {
+      RingStats s;
+      s.produced = _produced.load(std::memory_order_relaxed);
+      s.consumed = _consumed.load(std::memory_order_relaxed);
+      s.dropped = _dropped.load(std::memory_order_relaxed);
+      s.overwritten = 0;
+      s.depth = size();
+      s.highWater = _highWater.load(std::memory_order_relaxed);
+      return s;
+   }
+
+private:
+   std::unique_ptr<T[]> _items;
+   const size_t _capacity;
+
+   // Producer side
+   alignas(CACHE_LINE) std::atomic<size_t> _head{0};
+   size_t _tailCache = 0;
+   std::atomic<uint64_t> _produced{0};
+   std::atomic<uint64_t> _dropped{0};
+   std::atomic<size_t> _highWater{0};
+
+   // Consumer side
+   alignas(CACHE_LINE) std::atomic<size_t> _tail{0};
+   size_t _headCache = 0;
+   std::atomic<uint64_t> _consumed{0};
+};
+
+/* Nodes are registered with the Sequencer as services, so placement,
+ * priority, period, timing stats and the schedulability check all come from
+ * there; a node only talks to others through the edges it was given.
+ * Edges are any queue with stats() and capacity() (CircularBuffer,
+ * SpscQueue), and their occupancy is what the pipeline reports. */
+class Pipeline
+{
+public:
+   explicit Pipeline(Sequencer &sequencer) : _sequencer(sequencer) {}
+
+   template <typename F>
+   void addNode(const char *name, F &&work, uint8_t cpu, uint8_t priority, uint32_t period, uint32_t wcetUs = 0)
+   {
+      _sequencer.addService(std::forward<F>(work), cpu, priority, period, name, wcetUs);
+      _nodes.push_back({name, cpu, priority, period});
+   }
+
+   /* A node outside the Sequencer, e.g. a capture thread or the render loop
+    * on the main thread, listed so the graph is complete. */
+   void addExternalNode(const char *name, const char *runsOn)
+   {
+      _nodes.push_back({std::string(name) + " (" + runsOn + ")", 0, 0, 0});
+   }
+
+   template <typename Queue>
+   void addEdge(const char *name, const char *from, const char *to, Queue *queue)
+   {
+      _edges.push_back({name, from, to, [queue] { return queue->stats(); }, queue->capacity()});
+   }
+
+   void printGraph()
+   {
+      std::cout << "Pipeline:" << std::endl;
+      for (auto &n : _nodes)
+      {
+         if (n.period == 0)
+         {
+            std::cout << "  node " << n.name << std::endl;
+         }
+         else
+         {
+            std::cout << "  node " << n.name << ": cpu " << (int)n.cpu << ", prio " << (int)n.priority
+                      << ", every " << n.period << "ms" << std::endl;
+         }
+      }
+      for (auto &e : _edges)
+      {
+         std::cout << "  edge " << e.from << " -> [" << e.name << ", " << e.capacity << "] -> " << e.to
+                   << std::endl;
+      }
+   }
+
+   /* One syslog line per edge; cheap enough for a 1 s monitor service. */
+   void logEdges()
+   {
+      for (auto &e : _edges)
+      {
+         RingStats s = e.stats();
+         syslog(LOG_INFO, "%s edge: produced %lu consumed %lu dropped %lu overwritten %lu depth %zu/%zu high water %zu",
+                e.name.c_str(), (unsigned long)s.produced, (unsigned long)s.consumed,
+                (unsigned long)s.dropped, (unsigned long)s.overwritten, s.depth, e.capacity, s.highWater);
+      }
+   }
+
+   void printEdges()
+   {
+      for (auto &e : _edges)
+      {
+         RingStats s = e.stats();
+         std::cout << "\n***Printing stats for " << e.name << " edge (" << e.from << " -> " << e.to << ")***"
+                   << std::endl;
+         std::cout << "Produced: " << s.produced << std::endl;
+         std::cout << "Consumed: " << s.consumed << std::endl;
+         std::cout << "Dropped (full): " << s.dropped << std::endl;
+         std::cout << "Overwritten (oldest unread): " << s.overwritten << std::endl;
+         std::cout << "Depth: " << s.depth << "/" << e.capacity << ", high water " << s.highWater << std::endl;
+      }
+   }
+
+private:
+   struct Node
+   {
+      std::string name;
+      uint8_t cpu;
+      uint8_t priority;
+      uint32_t period; /* 0: not a Sequencer service */
+   };
+
+   struct Edge
+   {
+      std::string name;
+      std::string from;
+      std::string to;
+      std::function<RingStats(void)> stats;
+      size_t capacity;
+   };
+
+   Sequencer &_sequencer;
+   std::vector<Node> _nodes;
+   std::vector<Edge> _edges;
+};
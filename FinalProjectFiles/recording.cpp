@@ -0,0 +1,229 @@
+/*******************************************************************************
+ * class Recorder, RecordingReplay - see recording.h
+ * Final Project:  Aircraft Detection using Automatic Dependent
+ * Surveillance–Broadcast (ADSB) Data
+ * ECEN 5613 - Spring 2025
+ * University of Colorado Boulder
+*
+********************************************************************************/
+#include "recording.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <syslog.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+
+Recorder::Recorder(const std::string &path, uint32_t maxBlockSize)
+{
+   _fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+   if (_fd < 0)
+   {
+      throw std::runtime_error("Unable to create recording " + path + ": " + strerror(errno));
+   }
+
+   RecordingFileHeader h{};
+   h.magic = RECORDING_MAGIC;
+   h.version = 1;
+   h.maxBlockSize = maxBlockSize;
+   if (::write(_fd, &h, sizeof(h)) != sizeof(h))
+   {
+      close(_fd);
+      throw std::runtime_error("Unable to write recording header to " + path);
+   }
+}
+
+Recorder::~Recorder()
+{
+   if (_fd >= 0)
+   {
+      close(_fd);
+   }
+}
+
+void Recorder::write(const RTLBuffer &b)
+{
+   if (b.n_read <= 0)
+   {
+      return;
+   }
+
+   RecordingBlockHeader h{};
+   h.magic = RECORDING_BLOCK_MAGIC;
+   h.length = b.n_read;
+   h.frequency = b.frequency;
+   h.sampleRate = b.sampleRate;
+   h.sampleIndex = b.sampleIndex;
+   h.timestampNs = b.timestampNs;
+
+   struct iovec iov[2];
+   iov[0].iov_base = &h;
+   iov[0].iov_len = sizeof(h);
+   iov[1].iov_base = const_cast<uint8_t *>(b.buffer);
+   iov[1].iov_len = b.n_read;
+
+   // one writev per block keeps records whole when both services record
+   std::lock_guard<std::mutex> lock(_mutex);
+   ssize_t n = writev(_fd, iov, 2);
+   if (n != (ssize_t)(sizeof(h) + b.n_read))
+   {
+      if (_errors++ == 0)
+      {
+         syslog(LOG_ERR, "Recorder: short write (%s)", strerror(errno));
+      }
+      return;
+   }
+   _blocks++;
+   _bytes += b.n_read;
+}
+
+void Recorder::printStats()
+{
+   std::lock_guard<std::mutex> lock(_mutex);
+   std::cout << "\n***Printing stats for recorder***" << std::endl;
+   std::cout << "Blocks written: " << _blocks << std::endl;
+   std::cout << "IQ bytes written: " << _bytes << std::endl;
+   std::cout << "Write errors: " << _errors << std::endl;
+}
+
+RecordingReplay::RecordingReplay(const std::string &path)
+{
+   int fd = open(path.c_str(), O_RDONLY);
+   if (fd < 0)
+   {
+      throw std::runtime_error("Unable to open recording " + path + ": " + strerror(errno));
+   }
+
+   struct stat st;
+   if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(RecordingFileHeader))
+   {
+      close(fd);
+      throw std::runtime_error("Recording " + path + " is too short");
+   }
+   _size = st.st_size;
+
+   void *p = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+   close(fd);
+   if (p == MAP_FAILED)
+   {
+      throw std::runtime_error("Unable to map recording " + path + ": " + strerror(errno));
+   }
+   madvise(p, _size, MADV_SEQUENTIAL);
+   _data = static_cast<const uint8_t *>(p);
+
+   const RecordingFileHeader *h = reinterpret_cast<const RecordingFileHeader *>(_data);
+   if (h->magic != RECORDING_MAGIC || h->version != 1)
+   {
+      munmap(p, _size);
+      throw std::runtime_error(path + " is not a recording this build can replay");
+   }
+   _maxBlockSize = h->maxBlockSize;
+}
+
+RecordingReplay::~RecordingReplay()
+{
+   stop();
+   munmap(const_cast<uint8_t *>(_data), _size);
+}
+
+void RecordingReplay::start(uint32_t adsbFrequency, CircularBuffer *adsb, CircularBuffer *acars)
+{
+   _stop = false;
+   _done = false;
+   _thread = std::thread(&RecordingReplay::_run, this, adsbFrequency, adsb, acars);
+}
+
+void RecordingReplay::stop()
+{
+   _stop = true;
+   if (_thread.joinable())
+   {
+      _thread.join();
+   }
+}
+
+void RecordingReplay::_run(uint32_t adsbFrequency, CircularBuffer *adsb, CircularBuffer *acars)
+{
+   pthread_setname_np(pthread_self(), "replay");
+
+   auto start = std::chrono::steady_clock::now();
+   uint64_t firstNs = 0;
+   uint64_t lastNs = 0;
+   size_t offset = sizeof(RecordingFileHeader);
+
+   while (_stop == false && offset + sizeof(RecordingBlockHeader) <= _size)
+   {
+      const RecordingBlockHeader *h = reinterpret_cast<const RecordingBlockHeader *>(_data + offset);
+      offset += sizeof(RecordingBlockHeader);
+      if (h->magic != RECORDING_BLOCK_MAGIC || h->sampleRate == 0 || h->length > _maxBlockSize ||
+          offset + h->length > _size)
+      {
+         syslog(LOG_ERR, "Replay: corrupt block at offset %zu, stopping", offset);
+         break;
+      }
+
+      CircularBuffer *ring = (h->frequency == adsbFrequency) ? adsb : acars;
+      RTLBuffer *b;
+      while ((b = ring->tryClaim()) == nullptr && _stop == false)
+      {
+         std::this_thread::sleep_for(std::chrono::microseconds(200));
+      }
+      if (b == nullptr)
+      {
+         break;
+      }
+      if (h->length > b->capacity)
+      {
+         syslog(LOG_ERR, "Replay: %u byte block does not fit the %u byte ring blocks, stopping",
+                h->length, b->capacity);
+         break;
+      }
+
+      memcpy(b->buffer, _data + offset, h->length);
+      b->n_read = h->length;
+      b->frequency = h->frequency;
+      b->sampleRate = h->sampleRate;
+      b->sampleIndex = h->sampleIndex;
+      b->timestampNs = h->timestampNs;
+      ring->commit();
+      offset += h->length;
+
+      if (_blocks++ == 0)
+      {
+         firstNs = h->timestampNs;
+      }
+      lastNs = h->timestampNs + (uint64_t)h->length / 2 * 1000000000ull / h->sampleRate;
+      _bytes += h->length;
+   }
+
+   // the replay is over once the decoders have consumed the last block
+   while (_stop == false && (adsb->is_empty() == false || acars->is_empty() == false))
+   {
+      std::this_thread::sleep_for(std::chrono::microseconds(200));
+   }
+
+   _elapsedNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start).count();
+   _recordedNs = lastNs - firstNs;
+   _done = true;
+   syslog(LOG_INFO, "Replay done: %lu blocks in %lu ms",
+          (unsigned long)_blocks, (unsigned long)(_elapsedNs / 1000000));
+}
+
+void RecordingReplay::printStats()
+{
+   std::cout << "\n***Printing stats for replay***" << std::endl;
+   std::cout << "Blocks replayed: " << _blocks << std::endl;
+   std::cout << "IQ bytes replayed: " << _bytes << std::endl;
+   if (_done && _elapsedNs > 0)
+   {
+      std::cout << "Wall time: " << _elapsedNs / 1000000 << "ms" << std::endl;
+      std::cout << "Throughput: " << (double)_bytes / _elapsedNs * 1000 << " MB/s" << std::endl;
+      std::cout << "Speed vs capture: " << (double)_recordedNs / _elapsedNs << "x" << std::endl;
+   }
+}
@@ -0,0 +1,92 @@
+/*******************************************************************************
+ * class Recorder, RecordingReplay - capture the tagged ADS-B and ACARS
+ * RTLBuffer blocks to disk and push them back through the same rings later,
+ * as fast as the decoders can take them, for profiling.
+ * Final Project:  Aircraft Detection using Automatic Dependent
+ * Surveillance–Broadcast (ADSB) Data
+ * ECEN 5613 - Spring 2025
+ * University of Colorado Boulder
+*
+********************************************************************************/
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "circularbuffer.h"
+
+/* File layout: one RecordingFileHeader, then for every block a
+ * RecordingBlockHeader followed by 'length' bytes of u8 IQ. All fields are
+ * host endian; recordings are meant to be replayed on the machine type that
+ * made them. */
+#define RECORDING_MAGIC 0x31434552534441ull /* "ADSREC1" */
+#define RECORDING_BLOCK_MAGIC 0x4b4c4242u  /* "BBLK" */
+
+struct RecordingFileHeader
+{
+   uint64_t magic;
+   uint32_t version;
+   uint32_t maxBlockSize;
+};
+
+struct RecordingBlockHeader
+{
+   uint32_t magic;
+   uint32_t length;
+   uint32_t frequency;
+   uint32_t sampleRate;
+   uint64_t sampleIndex;
+   uint64_t timestampNs;
+};
+
+class Recorder
+{
+public:
+   /* 'maxBlockSize' is the largest block any ring will hand over. */
+   Recorder(const std::string &path, uint32_t maxBlockSize);
+   ~Recorder();
+
+   /* Append one block; safe to call from both decoder services. */
+   void write(const RTLBuffer &b);
+   void printStats();
+
+private:
+   int _fd = -1;
+   std::mutex _mutex;
+   uint64_t _blocks = 0;
+   uint64_t _bytes = 0;
+   uint64_t _errors = 0;
+};
+
+class RecordingReplay
+{
+public:
+   explicit RecordingReplay(const std::string &path);
+   ~RecordingReplay();
+
+   /* Replay from a background thread. Blocks recorded at 'adsbFrequency'
+    * go to 'adsb', everything else to 'acars'. A full ring is waited on,
+    * never dropped, so every recorded block reaches the decoders. */
+   void start(uint32_t adsbFrequency, CircularBuffer *adsb, CircularBuffer *acars);
+   void stop();
+   bool isDone() { return _done; }
+   void printStats();
+
+private:
+   void _run(uint32_t adsbFrequency, CircularBuffer *adsb, CircularBuffer *acars);
+
+   const uint8_t *_data = nullptr;
+   size_t _size = 0;
+   uint32_t _maxBlockSize = 0;
+   std::thread _thread;
+   std::atomic<bool> _stop{false};
+   std::atomic<bool> _done{false};
+
+   uint64_t _blocks = 0;
+   uint64_t _bytes = 0;
+   uint64_t _recordedNs = 0; /* capture span covered by the replayed blocks */
+   uint64_t _elapsedNs = 0;
+};
@@ -2,3 +2,12 @@
 
 int initRtl(unsigned int* Fc_calculated);
 int runRtlSample_serial(unsigned char* rtlinbuff, int n_read);
+
+/* Counted on the ACARS thread and read from others, so both sides go
+ * through __atomic builtins. */
+extern unsigned long acarsMessageCount;
+
+static inline unsigned long acarsMessages(void)
+{
+	return __atomic_load_n(&acarsMessageCount, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,165 @@
+/*******************************************************************************
+ * class SampleSource, IqFileSource - see samplesource.h
+ * Final Project:  Aircraft Detection using Automatic Dependent
+ * Surveillance–Broadcast (ADSB) Data
+ * ECEN 5613 - Spring 2025
+ * University of Colorado Boulder
+*
+********************************************************************************/
+#include "samplesource.h"
+#include "adsb.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+SampleSource::~SampleSource()
+{
+   stopStreaming();
+}
+
+bool SampleSource::startStreaming(const uint32_t frequency, CircularBuffer *ring)
+{
+   if (ring == nullptr || _streaming)
+   {
+      return false;
+   }
+   _streamPosition = 0;
+   _streamFrequency = frequency;
+   _stopPump = false;
+   _streaming = true;
+   _streamThread = std::thread(&SampleSource::_pump, this, frequency, ring);
+   return true;
+}
+
+void SampleSource::stopStreaming()
+{
+   if (_streamThread.joinable() == false)
+   {
+      return;
+   }
+   _stopPump = true;
+   _streamThread.join();
+   _streaming = false;
+}
+
+void SampleSource::printStats()
+{
+   if (_transfers == 0)
+   {
+      return;
+   }
+   std::cout << "\n***Printing stats for " << name() << " stream***" << std::endl;
+   std::cout << "Transfers: " << _transfers << std::endl;
+   std::cout << "Samples received: " << _samplesReceived << std::endl;
+   std::cout << "Samples dropped (ring full): " << _samplesDropped << std::endl;
+   std::cout << "Continuity gaps: " << _gaps << std::endl;
+}
+
+void SampleSource::_deliver(CircularBuffer *ring, const uint8_t *buffer, uint32_t length)
+{
+   const uint64_t samples = length / 2;
+
+   _transfers++;
+   _samplesReceived += samples;
+
+   RTLBuffer *b = ring->claim();
+   if (b == nullptr || length > b->capacity)
+   {
+      _samplesDropped += samples;
+      _streamPosition += samples;
+      _gaps++;
+      return;
+   }
+
+   memcpy(b->buffer, buffer, length);
+   b->n_read = length;
+   b->sampleIndex = _streamPosition;
+   b->frequency = _streamFrequency;
+   b->sampleRate = MODES_DEFAULT_RATE;
+   b->timestampNs = captureTimeNs();
+   ring->commit();
+
+   _streamPosition += samples;
+}
+
+void SampleSource::_pump(const uint32_t frequency, CircularBuffer *ring)
+{
+   pthread_setname_np(pthread_self(), "source pump");
+
+   std::vector<uint8_t> block(ring->blockSize());
+   auto next = std::chrono::steady_clock::now();
+
+   while (_stopPump == false)
+   {
+      int n = read(frequency, block.data(), block.size());
+      if (n <= 0)
+      {
+         break;
+      }
+      _streamPosition += samplesSkipped();
+      _deliver(ring, block.data(), n);
+
+      // release blocks no faster than the dongle would
+      next += std::chrono::microseconds((uint64_t)n / 2 * 1000000 / MODES_DEFAULT_RATE);
+      std::this_thread::sleep_until(next);
+   }
+   _streaming = false;
+}
+
+IqFileSource::IqFileSource(const std::string &path, uint32_t frequency, bool loop)
+    : _frequency(frequency), _loop(loop)
+{
+   int fd = open(path.c_str(), O_RDONLY);
+   if (fd < 0)
+   {
+      throw std::runtime_error("Unable to open IQ file " + path + ": " + strerror(errno));
+   }
+
+   struct stat st;
+   if (fstat(fd, &st) < 0 || st.st_size < 2)
+   {
+      close(fd);
+      throw std::runtime_error("IQ file " + path + " is empty");
+   }
+   _size = st.st_size & ~(size_t)1; // whole I/Q pairs only
+
+   void *p = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+   close(fd);
+   if (p == MAP_FAILED)
+   {
+      throw std::runtime_error("Unable to map IQ file " + path + ": " + strerror(errno));
+   }
+   madvise(p, _size, MADV_SEQUENTIAL);
+   _data = static_cast<const uint8_t *>(p);
+}
+
+IqFileSource::~IqFileSource()
+{
+   stopStreaming();
+   munmap(const_cast<uint8_t *>(_data), _size);
+}
+
+int IqFileSource::read(const uint32_t frequency, uint8_t *buffer, uint32_t length)
+{
+   if (covers(frequency) == false)
+   {
+      return -1;
+   }
+
+   _looped = false;
+   if (_offset >= _size)
+   {
+      if (_loop == false)
+      {
+         return 0;
+      }
+      _offset = 0;
+      _looped = true;
+   }
+
+   uint32_t n = std::min<size_t>(length & ~1u, _size - _offset);
+   memcpy(buffer, _data + _offset, n);
+   _offset += n;
+   return n;
+}
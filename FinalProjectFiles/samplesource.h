@@ -0,0 +1,98 @@
+/*******************************************************************************
+ * class SampleSource - where the reader gets its u8 IQ blocks from. The RTL
+ * dongle (class RtlSdr in adsb.h) is one backend; IqFileSource replays a raw
+ * IQ capture and SyntheticSource (synthetic.h) generates traffic in-process,
+ * so the pipeline can run and be benchmarked on a machine without a dongle.
+ * Final Project:  Aircraft Detection using Automatic Dependent
+ * Surveillance–Broadcast (ADSB) Data
+ * ECEN 5613 - Spring 2025
+ * University of Colorado Boulder
+*
+********************************************************************************/
+#pragma once
+
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "circularbuffer.h"
+
+class SampleSource
+{
+public:
+   /* Stops the default stream. A subclass that streams its own way, or
+    * whose read() the pump may be in, stops it in its own destructor, as
+    * stopStreaming() called from here is the base one. */
+   virtual ~SampleSource();
+
+   /* Fill 'buffer' with up to 'length' bytes of interleaved u8 I/Q captured
+    * at 'frequency'. Returns the number of bytes read, 0 at end of input and
+    * -1 on error. */
+   virtual int read(const uint32_t frequency, uint8_t *buffer, uint32_t length) = 0;
+
+   /* Continuous capture into 'ring' from a background thread. The default
+    * implementation calls read() in a loop paced to the sample rate, which
+    * is what a dongle in async mode would look like to the decoders. */
+   virtual bool startStreaming(const uint32_t frequency, CircularBuffer *ring);
+   virtual void stopStreaming();
+   virtual void printStats();
+
+   /* False for sources that only hold one band, so the reader can skip the
+    * other one instead of consuming samples it would throw away. */
+   virtual bool covers(const uint32_t frequency) { (void)frequency; return true; }
+
+   /* Samples that went by unread between the previous read() and the last
+    * one, so the caller can move its stream position over them. Only a
+    * live source loses any: a file or a generator carries on where it
+    * stopped, however long it is left between reads. A file that loops
+    * reports one at the loop, as its start does not follow on from its end. */
+   virtual uint64_t samplesSkipped() { return 0; }
+
+   virtual const char *name() = 0;
+   bool isStreaming() { return _streaming; }
+
+protected:
+   std::thread _streamThread;
+   std::atomic<bool> _streaming{false};
+
+   /* Sample-continuity accounting, all in IQ samples. _streamPosition is
+    * the stream time of the next sample the source will deliver. */
+   uint64_t _streamPosition = 0;
+   uint32_t _streamFrequency = 0;
+   std::atomic<uint64_t> _transfers{0};
+   std::atomic<uint64_t> _samplesReceived{0};
+   std::atomic<uint64_t> _samplesDropped{0}; /* ring full, block discarded */
+   std::atomic<uint64_t> _gaps{0};
+
+   /* Hands one captured block to the ring, or accounts for it as dropped. */
+   void _deliver(CircularBuffer *ring, const uint8_t *buffer, uint32_t length);
+
+private:
+   void _pump(const uint32_t frequency, CircularBuffer *ring);
+   std::atomic<bool> _stopPump{false};
+};
+
+/* Raw interleaved u8 I/Q file (rtl_sdr -s 2000000 output), memory mapped.
+ * The file carries no metadata, so the caller says which frequency it was
+ * captured on and every read() of that frequency returns the next chunk. */
+class IqFileSource : public SampleSource
+{
+public:
+   IqFileSource(const std::string &path, uint32_t frequency, bool loop);
+   ~IqFileSource();
+   int read(const uint32_t frequency, uint8_t *buffer, uint32_t length) override;
+   bool covers(const uint32_t frequency) override { return frequency == _frequency; }
+   uint64_t samplesSkipped() override { return _looped ? 1 : 0; }
+   const char *name() override { return "iq file"; }
+
+private:
+   const uint8_t *_data = nullptr;
+   size_t _size = 0;
+   size_t _offset = 0;
+   uint32_t _frequency;
+   bool _loop;
+   bool _looped = false; /* the last read() started over from the beginning */
+};
@@ -0,0 +1,688 @@
+/*******************************************************************************
+ * class SyntheticSource - see synthetic.h
+ * Final Project:  Aircraft Detection using Automatic Dependent
+ * Surveillance–Broadcast (ADSB) Data
+ * ECEN 5613 - Spring 2025
+ * University of Colorado Boulder
+*
+********************************************************************************/
+#include "synthetic.h"
+#include "adsb.h"
+#include "modescrc.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+
+#define FRAME_SAMPLES (MODES_FULL_LEN * 2) /* 120 us at 2 MS/s, the longest frame */
+#define FRAME_GUARD 4                      /* gap kept between frames when overlap is off */
+
+#define ACARS_BAUD 2400
+#define ACARS_PREKEY_BITS 112 /* ~47 ms of ones for the MSK PLL to lock on */
+#define ACARS_TAIL_BITS 16
+#define ACARS_GUARD (MODES_DEFAULT_RATE / 100)
+
+bool SyntheticConfig::parse(char *spec)
+{
+   enum { RATE, IDENT, SURV, ACARS, NOISE, AMIN, AMAX, OVERLAP, TRUTH, SEED };
+   char kRate[] = "rate", kIdent[] = "ident", kSurv[] = "surv", kAcars[] = "acars", kNoise[] = "noise",
+        kAmin[] = "amin", kAmax[] = "amax", kOverlap[] = "overlap", kTruth[] = "truth", kSeed[] = "seed";
+   char *const keys[] = {kRate, kIdent, kSurv, kAcars, kNoise, kAmin, kAmax, kOverlap, kTruth, kSeed, nullptr};
+
+   char *value;
+   while (*spec != '\0')
+   {
+      int key = getsubopt(&spec, keys, &value);
+      if (key < 0 || value == nullptr)
+      {
+         return false;
+      }
+      switch (key)
+      {
+      case RATE:
+         squitterRate = atof(value);
+         break;
+      case IDENT:
+         identRate = atof(value);
+         break;
+      case SURV:
+         survRate = atof(value);
+         break;
+      case ACARS:
+         acarsRate = atof(value);
+         break;
+      case NOISE:
+         noise = atof(value);
+         break;
+      case AMIN:
+         minAmplitude = atof(value);
+         break;
+      case AMAX:
+         maxAmplitude = atof(value);
+         break;
+      case OVERLAP:
+         overlap = atoi(value) != 0;
+         break;
+      case TRUTH:
+         truthPath = value;
+         break;
+      case SEED:
+         seed = strtoul(value, nullptr, 0);
+         break;
+      }
+   }
+   return true;
+}
+
+SyntheticSource::SyntheticSource(const SyntheticConfig &config) : _config(config), _rng(config.seed)
+{
+   if (_config.maxAmplitude < _config.minAmplitude)
+   {
+      std::swap(_config.minAmplitude, _config.maxAmplitude);
+   }
+
+   if (_config.truthPath.empty() == false)
+   {
+      _truth = fopen(_config.truthPath.c_str(), "w");
+      if (_truth == nullptr)
+      {
+         throw std::runtime_error("Unable to create " + _config.truthPath + ": " + strerror(errno));
+      }
+      fprintf(_truth, "sample,frequency,kind,address,latitude,longitude,altitude,text,amplitude,overlap,state\n");
+   }
+
+   std::uniform_real_distribution<double> lat(BOTTOM_LAT, TOP_LAT);
+   std::uniform_real_distribution<double> lon(LEFT_LON, RIGHT_LON);
+   std::uniform_real_distribution<double> speed(-0.004, 0.004); // degrees/s, up to ~500 kt
+   std::uniform_int_distribution<int> alt(40, 1400);          // x25 ft
+   std::uniform_real_distribution<float> amplitude(_config.minAmplitude, _config.maxAmplitude);
+
+   for (int i = 0; i < _config.aircraft; i++)
+   {
+      Emitter e;
+      e.addr = 0xC00000 + (uint32_t)i; // Canadian block, one per aircraft
+      snprintf(e.callsign, sizeof(e.callsign), "SYN%05d", i % 100000);
+      e.lat = lat(_rng);
+      e.lon = lon(_rng);
+      e.dlat = speed(_rng) / 2;
+      e.dlon = speed(_rng);
+      e.altitude = alt(_rng) * 25;
+      e.squawk = 01000 + (i % 06000); // 1000 - 6777, no emergency codes
+      e.amplitude = amplitude(_rng);
+      e.odd = false;
+      e.squawkNext = false;
+      e.nextPosition = 0;
+      e.nextIdent = 0;
+      e.nextReply = UINT64_MAX;
+      _schedule(e.nextPosition, _config.squitterRate);
+      _schedule(e.nextIdent, _config.identRate);
+      if (_config.survRate > 0)
+      {
+         e.nextReply = 0;
+         _schedule(e.nextReply, _config.survRate);
+      }
+      _emitters.push_back(e);
+   }
+
+   const double freq[] = SYNTHETIC_ACARS_FREQS;
+   for (int n = 0; n < SYNTHETIC_ACARS_CHANNELS; n++)
+   {
+      // same rounding to the channelizer rate as initRtl()
+      _channelFreq[n] = ((int)(1000000 * freq[n] + INTRATE / 2) / INTRATE) * INTRATE;
+      _nextBurst[n] = 0;
+      _schedule(_nextBurst[n], _config.acarsRate / 60);
+   }
+
+   /* Reading a precomputed table through a cheap generator keeps the noise
+    * from dominating the cost of generation at high aircraft counts. */
+   std::normal_distribution<float> noise(0.0f, _config.noise);
+   _noiseTable.resize(1 << 16);
+   for (float &v : _noiseTable)
+   {
+      v = noise(_rng);
+   }
+   _noiseState = _rng() | 1;
+}
+
+SyntheticSource::~SyntheticSource()
+{
+   stopStreaming();
+   if (_truth != nullptr)
+   {
+      fclose(_truth);
+   }
+}
+
+/* Advance 'next' by an exponential interval, i.e. Poisson arrivals at
+ * 'rate' per second. A zero rate never fires. */
+void SyntheticSource::_schedule(uint64_t &next, float rate)
+{
+   if (rate <= 0)
+   {
+      next = UINT64_MAX;
+      return;
+   }
+   std::exponential_distribution<double> interval(rate);
+   next += 1 + (uint64_t)(interval(_rng) * MODES_DEFAULT_RATE);
+}
+
+void SyntheticSource::_position(const Emitter &e, uint64_t sample, double &lat, double &lon)
+{
+   /* Fly straight, wrapping around inside the map bounds. */
+   double t = (double)sample / MODES_DEFAULT_RATE;
+   double h = TOP_LAT - BOTTOM_LAT;
+   double w = RIGHT_LON - LEFT_LON;
+   lat = BOTTOM_LAT + fmod(fmod(e.lat - BOTTOM_LAT + e.dlat * t, h) + h, h);
+   lon = LEFT_LON + fmod(fmod(e.lon - LEFT_LON + e.dlon * t, w) + w, w);
+}
+
+/* Always positive MOD, as in Adsb::cprModFunction but for doubles. */
+static double cprMod(double a, double b)
+{
+   double res = fmod(a, b);
+   if (res < 0)
+      res += b;
+   return res;
+}
+
+/* Number of longitude zones at 'lat' (the closed form behind the
+ * 1090-WP-9-14 table that Adsb::cprNLFunction uses). */
+static int cprNL(double lat)
+{
+   if (fabs(lat) >= 87.0)
+      return 1;
+   double a = 1 - cos(M_PI / (2 * 15));
+   double b = cos(M_PI / 180.0 * fabs(lat));
+   return (int)floor(2 * M_PI / acos(1 - a / (b * b)));
+}
+
+/* Samples 'msg' takes on the air, preamble included: 64 us for a 56 bit
+ * frame, 120 us for a 112 bit one. */
+static uint64_t frameSamples(const unsigned char *msg)
+{
+   return (MODES_PREAMBLE_US + Adsb::modesMessageLenByType(msg[0] >> 3)) * 2;
+}
+
+static void setChecksum(unsigned char *msg)
+{
+   uint32_t crc = modesCrc(msg, MODES_LONG_MSG_BITS);
+   msg[11] = crc >> 16;
+   msg[12] = crc >> 8;
+   msg[13] = crc;
+}
+
+/* Address/Parity: the parity of a 56 bit frame XORed with the address. */
+static void setAddressParity(unsigned char *msg, uint32_t addr)
+{
+   uint32_t crc = modesCrc(msg, MODES_SHORT_MSG_BITS) ^ addr;
+   msg[4] = crc >> 16;
+   msg[5] = crc >> 8;
+   msg[6] = crc;
+}
+
+/* Build a DF17 TC 11 airborne position squitter for 'e' as of 'sample',
+ * alternating even and odd CPR frames. */
+void SyntheticSource::_encodePosition(Emitter &e, uint64_t sample, unsigned char *msg)
+{
+   double lat, lon;
+   _position(e, sample, lat, lon);
+
+   int i = e.odd ? 1 : 0;
+   double dlat = 360.0 / (60 - i);
+   int yz = (int)floor(131072 * cprMod(lat, dlat) / dlat + 0.5);
+   double rlat = dlat * (yz / 131072.0 + floor(lat / dlat));
+   int nl = std::max(cprNL(rlat) - i, 1);
+   double dlon = 360.0 / nl;
+   int xz = (int)floor(131072 * cprMod(lon, dlon) / dlon + 0.5);
+   uint32_t lat17 = yz & 0x1FFFF;
+   uint32_t lon17 = xz & 0x1FFFF;
+
+   /* 12 bit altitude with the Q bit set: 25 ft steps above -1000 ft */
+   int n = (e.altitude + 1000) / 25;
+   int alt12 = ((n >> 4) << 5) | (1 << 4) | (n & 0xF);
+
+   msg[0] = (17 << 3) | 5; // DF17, CA 5
+   msg[1] = e.addr >> 16;
+   msg[2] = e.addr >> 8;
+   msg[3] = e.addr;
+   msg[4] = 11 << 3; // TC 11, no surveillance status
+   msg[5] = alt12 >> 4;
+   msg[6] = ((alt12 & 0xF) << 4) | (i << 2) | (lat17 >> 15);
+   msg[7] = lat17 >> 7;
+   msg[8] = ((lat17 & 0x7F) << 1) | (lon17 >> 16);
+   msg[9] = lon17 >> 8;
+   msg[10] = lon17;
+   setChecksum(msg);
+
+   e.odd = !e.odd;
+}
+
+/* Build a DF17 TC 4 identification squitter carrying the callsign. */
+void SyntheticSource::_encodeIdent(const Emitter &e, unsigned char *msg)
+{
+   static const char *ais_charset = "?ABCDEFGHIJKLMNOPQRSTUVWXYZ????? ???????????????0123456789??????";
+
+   uint64_t chars = 0;
+   for (int k = 0; k < 8; k++)
+   {
+      const char *p = strchr(ais_charset, e.callsign[k]);
+      chars = (chars << 6) | (uint64_t)(p != nullptr ? p - ais_charset : 32);
+   }
+
+   msg[0] = (17 << 3) | 5;
+   msg[1] = e.addr >> 16;
+   msg[2] = e.addr >> 8;
+   msg[3] = e.addr;
+   msg[4] = 4 << 3; // TC 4, category 0
+   for (int k = 0; k < 6; k++)
+   {
+      msg[5 + k] = chars >> (40 - 8 * k);
+   }
+   setChecksum(msg);
+}
+
+/* Build a surveillance reply, DF4 with the altitude and DF5 with the
+ * squawk in turn, as a ground interrogator would get them. The bits after
+ * the 56 are left 0. */
+void SyntheticSource::_encodeReply(Emitter &e, unsigned char *msg)
+{
+   memset(msg, 0, MODES_LONG_MSG_BYTES);
+   if (e.squawkNext)
+   {
+      /* identity bits C1 A1 C2 A2 C4 A4 0 B1 D1 B2 D2 B4 D4 */
+      int a = (e.squawk >> 9) & 7, b = (e.squawk >> 6) & 7, c = (e.squawk >> 3) & 7, d = e.squawk & 7;
+      msg[0] = 5 << 3; // DF5, airborne
+      msg[2] = ((c & 1) << 4) | ((a & 1) << 3) | ((c & 2) << 1) | (a & 2) | ((c & 4) >> 2);
+      msg[3] = ((a & 4) << 5) | ((b & 1) << 5) | ((d & 1) << 4) | ((b & 2) << 2) | ((d & 2) << 1) |
+               ((b & 4) >> 1) | ((d & 4) >> 2);
+   }
+   else
+   {
+      /* 13 bit altitude, M = 0, Q = 1: 25 ft steps above -1000 ft */
+      int n = (e.altitude + 1000) / 25;
+      msg[0] = 4 << 3; // DF4, airborne
+      msg[2] = (n >> 6) & 31;
+      msg[3] = ((n & 0x20) << 2) | ((n & 0x10) << 1) | (1 << 4) | (n & 15);
+   }
+   setAddressParity(msg, e.addr);
+   e.squawkNext = !e.squawkNext;
+}
+
+/* Pulse position modulation at 2 samples per microsecond: preamble pulses
+ * at samples 0, 2, 7 and 9, then a 1 is high-low and a 0 is low-high, for
+ * as many bits as the DF of 'msg' has (56 or 112). The
+ * carrier phase is random per message, as it is off the air. Adds into
+ * 'out' so that overlapping frames superpose. */
+void SyntheticSource::_modulate(std::complex<float> *out, const unsigned char *msg, float amplitude)
+{
+   std::uniform_real_distribution<float> phase(0, 2 * M_PI);
+   const std::complex<float> pulse = std::polar(amplitude, phase(_rng));
+
+   out[0] += pulse;
+   out[2] += pulse;
+   out[7] += pulse;
+   out[9] += pulse;
+   const int bits = Adsb::modesMessageLenByType(msg[0] >> 3);
+   for (int j = 0; j < bits; j++)
+   {
+      int bit = (msg[j / 8] >> (7 - j % 8)) & 1;
+      out[MODES_PREAMBLE_US * 2 + j * 2 + (bit ? 0 : 1)] += pulse;
+   }
+}
+
+/* Every squitter due in [start, end), in time order. Only rendered when
+ * the read is for 1090 MHz; otherwise it is lost, as it would be. */
+void SyntheticSource::_adsb(uint64_t start, uint64_t end, bool tuned)
+{
+   _frames.clear();
+   for (size_t i = 0; i < _emitters.size(); i++)
+   {
+      Emitter &e = _emitters[i];
+      for (; e.nextPosition < end; _schedule(e.nextPosition, _config.squitterRate))
+      {
+         _frames.push_back({e.nextPosition, i, POSITION});
+      }
+      for (; e.nextIdent < end; _schedule(e.nextIdent, _config.identRate))
+      {
+         _frames.push_back({e.nextIdent, i, IDENT});
+      }
+      for (; e.nextReply < end; _schedule(e.nextReply, _config.survRate))
+      {
+         _frames.push_back({e.nextReply, i, REPLY});
+      }
+   }
+   std::sort(_frames.begin(), _frames.end(),
+             [](const Frame &a, const Frame &b) { return a.sample < b.sample; });
+
+   for (const Frame &f : _frames)
+   {
+      Emitter &e = _emitters[f.emitter];
+      const bool reply = f.kind == REPLY; // DF4/DF5, counted apart from the DF17 squitters
+      uint64_t t = f.sample;
+      bool overlap = t < _adsbBusy;
+      if (overlap && _config.overlap == false)
+      {
+         // wait for the channel, possibly into the next read
+         (reply ? _repliesDeferred : _framesDeferred)++;
+         t = _adsbBusy + FRAME_GUARD;
+         overlap = false;
+         if (t >= end)
+         {
+            uint64_t &next = f.kind == IDENT ? e.nextIdent : f.kind == REPLY ? e.nextReply : e.nextPosition;
+            next = std::min(next, t);
+            continue;
+         }
+      }
+
+      unsigned char msg[MODES_LONG_MSG_BYTES];
+      const bool squawk = e.squawkNext;
+      if (f.kind == IDENT)
+      {
+         _encodeIdent(e, msg);
+      }
+      else if (f.kind == REPLY)
+      {
+         _encodeReply(e, msg);
+      }
+      else
+      {
+         _encodePosition(e, t, msg);
+      }
+      _adsbBusy = std::max(_adsbBusy, t + frameSamples(msg));
+
+      const char *state;
+      if (tuned == false)
+      {
+         state = "offband";
+         (reply ? _repliesOffBand : _framesOffBand)++;
+      }
+      else
+      {
+         _modulate(&_signal[t - start], msg, e.amplitude);
+         if (t + frameSamples(msg) <= end)
+         {
+            state = "full";
+            (reply ? _repliesFull : _framesFull)++;
+         }
+         else
+         {
+            state = "split";
+            (reply ? _repliesSplit : _framesSplit)++;
+         }
+      }
+      if (overlap)
+      {
+         (reply ? _repliesOverlapped : _framesOverlapped)++;
+      }
+
+      if (_truth != nullptr)
+      {
+         if (f.kind == REPLY && squawk)
+         {
+            fprintf(_truth, "%lu,%u,squawk,%06X,,,,%04o,%.1f,%d,%s\n", (unsigned long)t,
+                    (uint32_t)ADSB_FREQUENCY, e.addr, e.squawk, e.amplitude, overlap, state);
+         }
+         else if (f.kind == REPLY)
+         {
+            fprintf(_truth, "%lu,%u,altitude,%06X,,,%d,,%.1f,%d,%s\n", (unsigned long)t,
+                    (uint32_t)ADSB_FREQUENCY, e.addr, e.altitude, e.amplitude, overlap, state);
+         }
+         else if (f.kind == IDENT)
+         {
+            fprintf(_truth, "%lu,%u,ident,%06X,,,,%s,%.1f,%d,%s\n", (unsigned long)t,
+                    (uint32_t)ADSB_FREQUENCY, e.addr, e.callsign, e.amplitude, overlap, state);
+         }
+         else
+         {
+            double lat, lon;
+            _position(e, t, lat, lon);
+            fprintf(_truth, "%lu,%u,position,%06X,%.5f,%.5f,%d,,%.1f,%d,%s\n", (unsigned long)t,
+                    (uint32_t)ADSB_FREQUENCY, e.addr, lat, lon, e.altitude, e.amplitude, overlap, state);
+         }
+      }
+   }
+}
+
+/* ACARS characters are 7 bit ASCII with odd parity in the top bit. */
+static uint8_t oddParity(uint8_t c)
+{
+   return (__builtin_popcount(c & 0x7f) & 1) ? (c & 0x7f) : (c | 0x80);
+}
+
+/* One ACARS downlink block, modulated as the bit-decision phases of an MSK
+ * signal: at even bit boundaries the phase sits on the real axis, at odd
+ * ones on the imaginary axis, and it moves by +-pi/2 per bit in between.
+ * demodMSK() samples exactly those points, the real part on even and the
+ * imaginary part on odd decisions. */
+SyntheticSource::Burst SyntheticSource::_makeBurst(int channel, uint64_t start)
+{
+   uint32_t id = ++_burstCount;
+   std::uniform_real_distribution<float> amplitude(_config.minAmplitude, _config.maxAmplitude);
+   std::uniform_real_distribution<float> phase(0, 2 * M_PI);
+
+   Burst b;
+   b.channel = channel;
+   b.start = start;
+   b.delivered = 0;
+   b.amplitude = amplitude(_rng) / 2;
+   b.carrier = phase(_rng);
+   b.overlap = false;
+
+   char addr[8], text[64];
+   snprintf(addr, sizeof(addr), ".N%05u", id % 100000);
+   snprintf(text, sizeof(text), "M%02uAAC%04uSYNTHETIC LOAD %06u", id % 100, id % 10000, id);
+   b.addr = addr + 1;
+   b.text = text;
+
+   /* mode, address, NAK, label, block id, STX, text, ETX */
+   std::string txt = std::string("2") + addr + "\x15" + "H1" + (char)('0' + id % 10) + "\x02" + text + "\x03";
+   for (char &c : txt)
+   {
+      c = oddParity(c);
+   }
+
+   /* CRC-16/KERMIT over the text block, sent low byte first, so that the
+    * receiver's running crc (syndrom.h) ends at 0 */
+   uint16_t crc = 0;
+   for (uint8_t c : txt)
+   {
+      crc ^= c;
+      for (int k = 0; k < 8; k++)
+      {
+         crc = (crc & 1) ? (crc >> 1) ^ 0x8408 : crc >> 1;
+      }
+   }
+
+   std::string bytes = std::string() + (char)oddParity('+') + (char)oddParity('*') + "\x16\x16\x01" + txt;
+   bytes += (char)(crc & 0xff);
+   bytes += (char)(crc >> 8);
+   bytes += '\x7f'; // DEL
+
+   std::vector<int> bits(ACARS_PREKEY_BITS, 1);
+   for (uint8_t c : bytes)
+   {
+      for (int k = 0; k < 8; k++)
+      {
+         bits.push_back((c >> k) & 1); // LSB first
+      }
+   }
+   bits.insert(bits.end(), ACARS_TAIL_BITS, 1);
+
+   b.phase.resize(bits.size() + 1);
+   b.phase[0] = 0;
+   for (size_t m = 1; m <= bits.size(); m++)
+   {
+      // the demodulator inverts every other pair of decisions (MskS & 2)
+      bool v = bits[m - 1] ^ ((m & 2) != 0);
+      float target = (m & 1) ? (v ? M_PI / 2 : -M_PI / 2) : (v ? 0 : M_PI);
+      float step = remainderf(target - b.phase[m - 1], 2 * M_PI);
+      b.phase[m] = b.phase[m - 1] + step;
+   }
+   b.length = (uint64_t)bits.size() * MODES_DEFAULT_RATE / ACARS_BAUD;
+   return b;
+}
+
+void SyntheticSource::_finishBurst(const Burst &b)
+{
+   const char *state;
+   if (b.delivered == b.length)
+   {
+      state = "full";
+      _burstsFull++;
+   }
+   else if (b.delivered > 0)
+   {
+      state = "partial";
+      _burstsPartial++;
+   }
+   else
+   {
+      state = "offband";
+      _burstsOffBand++;
+   }
+
+   if (_truth != nullptr)
+   {
+      fprintf(_truth, "%lu,%u,acars,%s,,,,%s,%.1f,%d,%s\n", (unsigned long)b.start,
+              _channelFreq[b.channel], b.addr.c_str(), b.text.c_str(), b.amplitude, b.overlap, state);
+   }
+}
+
+/* Start the bursts due before 'end' and render what falls in [start, end)
+ * on every channel within the band around 'frequency'. */
+void SyntheticSource::_acars(uint64_t start, uint64_t end, uint32_t frequency)
+{
+   for (int n = 0; n < SYNTHETIC_ACARS_CHANNELS; n++)
+   {
+      while (_nextBurst[n] < end)
+      {
+         uint64_t t = _nextBurst[n];
+         bool overlap = t < _acarsBusy[n];
+         if (overlap && _config.overlap == false)
+         {
+            t = _acarsBusy[n] + ACARS_GUARD;
+            overlap = false;
+            if (t >= end)
+            {
+               _nextBurst[n] = t;
+               break;
+            }
+         }
+         _bursts.push_back(_makeBurst(n, t));
+         _bursts.back().overlap = overlap;
+         _acarsBusy[n] = std::max(_acarsBusy[n], t + _bursts.back().length);
+         _nextBurst[n] = t;
+         _schedule(_nextBurst[n], _config.acarsRate / 60);
+      }
+   }
+
+   const double fs = MODES_DEFAULT_RATE;
+   for (Burst &b : _bursts)
+   {
+      double offset = (double)_channelFreq[b.channel] - frequency;
+      uint64_t from = std::max(start, b.start);
+      uint64_t to = std::min(end, b.start + b.length);
+      if (frequency == ADSB_FREQUENCY || fabs(offset) > fs / 2 - INTRATE || from >= to)
+      {
+         continue;
+      }
+
+      for (uint64_t s = from; s < to; s++)
+      {
+         double t = (double)(s - b.start);
+         double bit = t * ACARS_BAUD / fs;
+         size_t k = (size_t)bit;
+         float theta = b.phase[k] + (b.phase[k + 1] - b.phase[k]) * (float)(bit - k);
+         float audio = cosf(fmod(2 * M_PI * 1800 * t / fs, 2 * M_PI) + theta);
+         double carrier = fmod(2 * M_PI * offset * (double)s / fs, 2 * M_PI) + b.carrier;
+         _signal[s - start] += std::polar(b.amplitude * (1 + 0.5f * audio), (float)carrier);
+      }
+      b.delivered += to - from;
+   }
+
+   auto done = std::remove_if(_bursts.begin(), _bursts.end(), [&](const Burst &b) {
+      if (b.start + b.length > end)
+      {
+         return false;
+      }
+      _finishBurst(b);
+      return true;
+   });
+   _bursts.erase(done, _bursts.end());
+}
+
+int SyntheticSource::read(const uint32_t frequency, uint8_t *buffer, uint32_t length)
+{
+   auto began = std::chrono::steady_clock::now();
+   const uint32_t n = length / 2;
+   const uint64_t start = _clock;
+   const uint64_t end = start + n;
+   const bool adsb = frequency == ADSB_FREQUENCY;
+
+   /* _signal keeps FRAME_SAMPLES past the block, where a frame that starts
+    * near the end lands; it belongs at the head of the next block if that
+    * one is ADS-B too. */
+   std::vector<std::complex<float>> carry;
+   if (adsb && _carryAt == start)
+   {
+      carry.assign(_signal.begin() + (_signal.size() - FRAME_SAMPLES), _signal.end());
+   }
+   _signal.assign(n + FRAME_SAMPLES, 0);
+   std::copy(carry.begin(), carry.end(), _signal.begin());
+
+   _adsb(start, end, adsb);
+   _acars(start, end, frequency);
+   _carryAt = adsb ? end : UINT64_MAX;
+
+   for (uint32_t j = 0; j < n; j++)
+   {
+      _noiseState ^= _noiseState << 13;
+      _noiseState ^= _noiseState >> 17;
+      _noiseState ^= _noiseState << 5;
+      float ni = _noiseTable[_noiseState & 0xffff];
+      float nq = _noiseTable[_noiseState >> 16];
+      buffer[j * 2] = std::clamp<int>(lrintf(127.5f + _signal[j].real() + ni), 0, 255);
+      buffer[j * 2 + 1] = std::clamp<int>(lrintf(127.5f + _signal[j].imag() + nq), 0, 255);
+   }
+   _clock = end;
+
+   _generateNs += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                      std::chrono::steady_clock::now() - began).count();
+   return n * 2;
+}
+
+void SyntheticSource::printStats()
+{
+   SampleSource::printStats();
+   std::cout << "\n***Printing stats for synthetic traffic***" << std::endl;
+   std::cout << "Aircraft: " << _emitters.size() << std::endl;
+   std::cout << "Samples generated: " << _clock << " (" << _clock / (MODES_DEFAULT_RATE / 1000) << "ms)" << std::endl;
+   std::cout << "DF17 frames delivered whole: " << _framesFull << std::endl;
+   std::cout << "DF17 frames split across blocks: " << _framesSplit << std::endl;
+   std::cout << "DF17 frames sent while tuned away: " << _framesOffBand << std::endl;
+   std::cout << "DF17 frames overlapping another: " << _framesOverlapped << std::endl;
+   std::cout << "DF17 frames deferred for a clear channel: " << _framesDeferred << std::endl;
+   if (_config.survRate > 0)
+   {
+      std::cout << "DF4/DF5 replies delivered whole: " << _repliesFull << std::endl;
+      std::cout << "DF4/DF5 replies split across blocks: " << _repliesSplit << std::endl;
+      std::cout << "DF4/DF5 replies sent while tuned away: " << _repliesOffBand << std::endl;
+      std::cout << "DF4/DF5 replies overlapping another: " << _repliesOverlapped << std::endl;
+      std::cout << "DF4/DF5 replies deferred for a clear channel: " << _repliesDeferred << std::endl;
+   }
+   std::cout << "ACARS bursts delivered whole: " << _burstsFull << std::endl;
+   std::cout << "ACARS bursts cut by a retune: " << _burstsPartial << std::endl;
+   std::cout << "ACARS bursts sent while tuned away: " << _burstsOffBand << std::endl;
+   if (_generateNs > 0)
+   {
+      std::cout << "Generation speed: " << (double)_clock / _generateNs * 1000 << " MS/s" << std::endl;
+   }
+   if (_truth != nullptr)
+   {
+      fflush(_truth);
+      std::cout << "Ground truth: " << _config.truthPath << std::endl;
+   }
+}
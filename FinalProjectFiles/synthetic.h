@@ -0,0 +1,150 @@
+/*******************************************************************************
+ * class SyntheticSource - load generator. Synthesizes 2 MS/s u8 IQ holding
+ * any number of DF17 emitters (with DF4/DF5 replies if asked) on 1090 MHz
+ * and ACARS MSK bursts on the three channels set up in initRtl(), over
+ * Gaussian noise, and writes the ground
+ * truth of everything it transmitted to a CSV so that decode rate and
+ * throughput can be measured in the same run.
+ * Final Project:  Aircraft Detection using Automatic Dependent
+ * Surveillance–Broadcast (ADSB) Data
+ * ECEN 5613 - Spring 2025
+ * University of Colorado Boulder
+*
+********************************************************************************/
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <complex>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "samplesource.h"
+
+/* Channels hard-coded in initRtl() (rtl.c), in MHz. */
+#define SYNTHETIC_ACARS_CHANNELS 3
+#define SYNTHETIC_ACARS_FREQS {131.475, 131.550, 131.725}
+
+struct SyntheticConfig
+{
+   int aircraft = 20;
+   float squitterRate = 2.0f;  /* DF17 airborne positions per aircraft per second */
+   float identRate = 0.2f;     /* DF17 identifications per aircraft per second */
+   float survRate = 0.0f;      /* DF4/DF5 replies (altitude, squawk in turn) per aircraft per second */
+   float acarsRate = 6.0f;     /* ACARS bursts per channel per minute */
+   float noise = 3.0f;         /* Gaussian sigma on I and on Q, in u8 counts */
+   float minAmplitude = 20.0f; /* per aircraft carrier amplitude, u8 counts */
+   float maxAmplitude = 100.0f;
+   bool overlap = true;        /* false: transmissions wait for a clear channel */
+   std::string truthPath;      /* ground truth CSV, none when empty */
+   unsigned seed = 1090;
+
+   /* Parse "key=value,..." as given to -G. Returns false on a bad key. */
+   bool parse(char *spec);
+};
+
+/* Traffic lives on one sample timeline that advances with every read(),
+ * whatever band it is for, like a dongle that keeps being retuned: what
+ * is transmitted while the reader listens to the other band is lost, and
+ * is recorded as such in the ground truth. */
+class SyntheticSource : public SampleSource
+{
+public:
+   explicit SyntheticSource(const SyntheticConfig &config);
+   ~SyntheticSource();
+   int read(const uint32_t frequency, uint8_t *buffer, uint32_t length) override;
+   void printStats() override;
+   const char *name() override { return "synthetic"; }
+
+   /* Transmissions that reached a read() of their band in full: DF17
+    * squitters, DF4/DF5 replies (surv=) and ACARS bursts. */
+   uint64_t framesDelivered() { return _framesFull; }
+   uint64_t repliesDelivered() { return _repliesFull; }
+   uint64_t burstsDelivered() { return _burstsFull; }
+
+private:
+   struct Emitter
+   {
+      uint32_t addr;
+      char callsign[9];
+      double lat, lon;   /* position at sample 0 */
+      double dlat, dlon; /* degrees per second */
+      int altitude;
+      int squawk; /* four octal digits */
+      float amplitude;
+      bool odd;
+      bool squawkNext; /* DF5 rather than DF4 for the next reply */
+      uint64_t nextPosition;
+      uint64_t nextIdent;
+      uint64_t nextReply;
+   };
+
+   enum FrameKind { POSITION, IDENT, REPLY };
+
+   struct Frame
+   {
+      uint64_t sample;
+      size_t emitter;
+      FrameKind kind;
+   };
+
+   struct Burst
+   {
+      int channel;
+      uint64_t start;
+      uint64_t length;    /* samples */
+      uint64_t delivered; /* samples that went out on an ACARS read */
+      std::vector<float> phase; /* MSK phase at every bit boundary */
+      float amplitude;
+      float carrier;
+      bool overlap;
+      std::string addr;
+      std::string text;
+   };
+
+   void _schedule(uint64_t &next, float rate);
+   void _position(const Emitter &e, uint64_t sample, double &lat, double &lon);
+   void _encodePosition(Emitter &e, uint64_t sample, unsigned char *msg);
+   void _encodeIdent(const Emitter &e, unsigned char *msg);
+   void _encodeReply(Emitter &e, unsigned char *msg);
+   void _modulate(std::complex<float> *out, const unsigned char *msg, float amplitude);
+   void _adsb(uint64_t start, uint64_t end, bool tuned);
+   void _acars(uint64_t start, uint64_t end, uint32_t frequency);
+   Burst _makeBurst(int channel, uint64_t start);
+   void _finishBurst(const Burst &b);
+
+   SyntheticConfig _config;
+   std::vector<Emitter> _emitters;
+   std::vector<Frame> _frames;
+   std::vector<Burst> _bursts;
+   uint64_t _nextBurst[SYNTHETIC_ACARS_CHANNELS];
+   uint32_t _channelFreq[SYNTHETIC_ACARS_CHANNELS];
+   uint64_t _acarsBusy[SYNTHETIC_ACARS_CHANNELS] = {};
+   uint64_t _adsbBusy = 0;
+   uint32_t _burstCount = 0;
+
+   uint64_t _clock = 0; /* sample time of the next read() */
+   std::vector<std::complex<float>> _signal;
+   uint64_t _carryAt = UINT64_MAX; /* where the ADS-B tail in _signal belongs */
+
+   std::vector<float> _noiseTable;
+   uint32_t _noiseState;
+   std::mt19937 _rng;
+   FILE *_truth = nullptr;
+
+   uint64_t _framesFull = 0;
+   uint64_t _framesSplit = 0;   /* ran past the end of the block */
+   uint64_t _framesOffBand = 0; /* sent while tuned elsewhere */
+   uint64_t _framesOverlapped = 0;
+   uint64_t _framesDeferred = 0;
+   uint64_t _repliesFull = 0;   /* the same for DF4/DF5 replies */
+   uint64_t _repliesSplit = 0;
+   uint64_t _repliesOffBand = 0;
+   uint64_t _repliesOverlapped = 0;
+   uint64_t _repliesDeferred = 0;
+   uint64_t _burstsFull = 0;
+   uint64_t _burstsPartial = 0;
+   uint64_t _burstsOffBand = 0;
+   uint64_t _generateNs = 0;
+};
@@ -0,0 +1,113 @@
+/*******************************************************************************
+ * class WorkerPool - persistent threads that run one indexed job each per
+ * call to run(), for splitting a block of work across CPUs
+ * Final Project:  Aircraft Detection using Automatic Dependent
+ * Surveillance–Broadcast (ADSB) Data
+ * ECEN 5613 - Spring 2025
+ * University of Colorado Boulder
+*
+********************************************************************************/
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/* run(fn) calls fn(0) on the caller and fn(1) .. fn(size() - 1) on the
+ * workers, and returns once all of them are done. The threads are created
+ * once, so a periodic service pays a wake-up per job rather than a thread
+ * start. 'setup' runs first on each worker, e.g. to pin it and set its
+ * priority. */
+class WorkerPool
+{
+public:
+   WorkerPool(size_t jobs, std::function<void(size_t worker)> setup = nullptr)
+   {
+      for (size_t k = 1; k < jobs; k++)
+      {
+         _threads.emplace_back([this, k, setup] {
+            if (setup)
+            {
+               setup(k);
+            }
+            _work(k);
+         });
+      }
+   }
+
+   ~WorkerPool()
+   {
+      {
+         std::lock_guard<std::mutex> lock(_mutex);
+         _stop = true;
+      }
+      _wake.notify_all();
+      for (auto &t : _threads)
+      {
+         t.join();
+      }
+   }
+
+   WorkerPool(const WorkerPool &) = delete;
+   WorkerPool &operator=(const WorkerPool &) = delete;
+
+   size_t size() { return _threads.size() + 1; }
+
+   void run(const std::function<void(size_t job)> &fn)
+   {
+      {
+         std::lock_guard<std::mutex> lock(_mutex);
+         _job = &fn;
+         _pending = _threads.size();
+         _generation++;
+      }
+      _wake.notify_all();
+
+      fn(0);
+
+      std::unique_lock<std::mutex> lock(_mutex);
+      _done.wait(lock, [this] { return _pending == 0; });
+      _job = nullptr;
+   }
+
+private:
+   void _work(size_t k)
+   {
+      uint64_t seen = 0;
+      while (true)
+      {
+         const std::function<void(size_t)> *job;
+         {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _wake.wait(lock, [this, seen] { return _stop || _generation != seen; });
+            if (_stop)
+            {
+               return;
+            }
+            seen = _generation;
+            job = _job;
+         }
+
+         (*job)(k);
+
+         std::lock_guard<std::mutex> lock(_mutex);
+         if (--_pending == 0)
+         {
+            _done.notify_one();
+         }
+      }
+   }
+
+   std::vector<std::thread> _threads;
+   std::mutex _mutex;
+   std::condition_variable _wake;
+   std::condition_variable _done;
+   const std::function<void(size_t)> *_job = nullptr;
+   size_t _pending = 0;
+   uint64_t _generation = 0;
+   bool _stop = false;
+};